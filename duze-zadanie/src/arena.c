@@ -0,0 +1,125 @@
+/** @file
+ * Implementacja areny.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#include "arena.h"
+#include "safe_memory_allocation.h"
+#include <stdalign.h>
+#include <stddef.h>
+
+/**
+ * Najmniejszy rozmiar bloku dokładanego do areny.
+ */
+#define ARENA_MIN_CHUNK_SIZE (64 * 1024)
+
+/**
+ * Wyrównanie przydziałów.
+ */
+#define ARENA_ALIGNMENT alignof(max_align_t)
+
+/**
+ * Blok pamięci areny. Bloki tworzą listę w kolejności dokładania.
+ */
+typedef struct ArenaChunk {
+    struct ArenaChunk *next; ///< następny blok
+    size_t size;             ///< rozmiar danych bloku w bajtach
+    char *data;              ///< dane bloku, umieszczone zaraz za nagłówkiem
+} ArenaChunk;
+
+/**
+ * Arena.
+ */
+struct Arena {
+    ArenaChunk *current; ///< blok, w którym przydzielana jest pamięć
+    char *next;          ///< początek wolnej pamięci w bieżącym bloku
+    char *end;           ///< koniec bieżącego bloku
+    ArenaChunk first;    ///< pierwszy blok, przydzielony razem z areną
+};
+
+/**
+ * Zaokrągla rozmiar w górę do wielokrotności wyrównania przydziałów.
+ * @param size : rozmiar w bajtach,
+ * @return zaokrąglony rozmiar.
+ */
+static inline size_t AlignSize(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * Ustawia blok jako bieżący.
+ * @param arena : arena,
+ * @param chunk : blok.
+ */
+static inline void UseChunk(Arena *arena, ArenaChunk *chunk) {
+    arena->current = chunk;
+    arena->next = chunk->data;
+    arena->end = chunk->data + chunk->size;
+}
+
+Arena *ArenaCreate(size_t initialSize) {
+    initialSize = AlignSize(initialSize);
+    Arena *arena = SafeMalloc(AlignSize(sizeof(Arena)) + initialSize);
+    arena->first = (ArenaChunk){.next = NULL, .size = initialSize,
+                                .data = (char *)arena + AlignSize(sizeof(Arena))};
+    UseChunk(arena, &arena->first);
+
+    return arena;
+}
+
+void *ArenaAlloc(Arena *arena, size_t size) {
+    size = AlignSize(size);
+
+    while ((size_t)(arena->end - arena->next) < size) {
+        ArenaChunk *chunk = arena->current->next;
+        if (chunk == NULL || chunk->size < size) {
+            size_t chunkSize = 2 * arena->current->size;
+            if (chunkSize < ARENA_MIN_CHUNK_SIZE) {
+                chunkSize = ARENA_MIN_CHUNK_SIZE;
+            }
+            if (chunkSize < size) {
+                chunkSize = size;
+            }
+
+            ArenaChunk *newChunk = SafeMalloc(AlignSize(sizeof(ArenaChunk)) + chunkSize);
+            *newChunk = (ArenaChunk){.next = arena->current->next, .size = chunkSize,
+                                     .data = (char *)newChunk + AlignSize(sizeof(ArenaChunk))};
+            arena->current->next = newChunk;
+            chunk = newChunk;
+        }
+        UseChunk(arena, chunk);
+    }
+
+    void *result = arena->next;
+    arena->next += size;
+    return result;
+}
+
+size_t ArenaAllocationSize(size_t size) {
+    return AlignSize(size);
+}
+
+size_t ArenaSize(const Arena *arena) {
+    size_t size = 0;
+    for (const ArenaChunk *chunk = &arena->first; chunk != NULL; chunk = chunk->next) {
+        size += chunk->size;
+    }
+    return size;
+}
+
+void ArenaReset(Arena *arena) {
+    UseChunk(arena, &arena->first);
+}
+
+void ArenaDestroy(Arena *arena) {
+    ArenaChunk *chunk = arena->first.next;
+    while (chunk != NULL) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
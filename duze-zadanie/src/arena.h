@@ -0,0 +1,64 @@
+/** @file
+ * Interfejs areny - alokatora przydzielającego pamięć przez przesuwanie wskaźnika
+ * (ang. bump allocator). Pojedynczych przydziałów nie da się zwolnić; pamięć całej areny
+ * zwalnia się albo odzyskuje naraz.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#ifndef POLYNOMIALS_ARENA_H
+#define POLYNOMIALS_ARENA_H
+
+#include <stddef.h>
+
+/**
+ * Arena. Pełna definicja jest prywatna dla implementacji.
+ */
+typedef struct Arena Arena;
+
+/**
+ * Tworzy arenę. Arena i jej pierwszy blok zajmują jeden przydział pamięci, więc arena,
+ * w której zmieszczą się wszystkie przydziały, kosztuje jedno wywołanie malloc i free.
+ * @param initialSize : rozmiar pierwszego bloku w bajtach,
+ * @return wskaźnik na arenę.
+ */
+Arena *ArenaCreate(size_t initialSize);
+
+/**
+ * Przydziela pamięć w arenie. Jeśli w bieżącym bloku brakuje miejsca, wykorzystywany jest
+ * kolejny blok albo przydzielany nowy.
+ * @param arena : arena,
+ * @param size : rozmiar w bajtach,
+ * @return wskaźnik na pamięć wyrównaną jak dla dowolnego typu.
+ */
+void *ArenaAlloc(Arena *arena, size_t size);
+
+/**
+ * Zwraca liczbę bajtów areny zużywanych przez przydział danego rozmiaru.
+ * @param size : rozmiar przydziału w bajtach,
+ * @return rozmiar zaokrąglony do wyrównania przydziałów.
+ */
+size_t ArenaAllocationSize(size_t size);
+
+/**
+ * Zwraca łączny rozmiar bloków areny, także ich niewykorzystanej części.
+ * @param arena : arena,
+ * @return rozmiar w bajtach.
+ */
+size_t ArenaSize(const Arena *arena);
+
+/**
+ * Unieważnia wszystkie przydziały, zachowując bloki areny do ponownego użycia.
+ * @param arena : arena.
+ */
+void ArenaReset(Arena *arena);
+
+/**
+ * Zwalnia arenę wraz z całą przydzieloną w niej pamięcią.
+ * @param arena : arena.
+ */
+void ArenaDestroy(Arena *arena);
+
+#endif // POLYNOMIALS_ARENA_H
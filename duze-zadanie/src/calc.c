@@ -10,8 +10,11 @@
 
 #include "errors.h"
 #include "input_parser.h"
+#include "safe_memory_allocation.h"
 #include "stack.h"
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /**
@@ -55,8 +58,7 @@ void PrintMono(Mono m) {
  * @param p : wielomian rozmiaru 1 do wypisania.
  */
 void PrintPolyWithSize1(Poly p) {
-    poly_coeff_t tmp;
-    if (RecursivePolyIsCoeff(&p.arr[0].p, &tmp)) {
+    if (PolyIsCoeff(&p.arr[0].p)) {
         PrintPoly(p.arr[0].p);
     } else {
         printf("(");
@@ -124,30 +126,26 @@ void ExecuteClone(Stack *stack, unsigned int lineNumber) {
     if (IsEmpty(stack)) {
         PrintStackUnderflow(lineNumber);
     } else {
-        Poly peekPoly = Peek(stack);
-        Poly result = PolyClone(&peekPoly);
-        Push(stack, result);
+        Duplicate(stack);
     }
 }
 
 /**
- * Wykonuje polecenie ADD, SUB lub MUL.
+ * Wykonuje polecenie ADD, SUB lub MUL. Zdjęte ze stosu wielomiany są przekazywane na
+ * własność funkcji, która wykorzystuje ich pamięć do zbudowania wyniku.
  * @param stack : stos wielomianów,
  * @param lineNumber : numer linii na której wystąpiło polecenie.
- * @param function : wskaźnik na funkcję PolyAdd, PolySub albo PolyMul, którą będziemy wykonywać.
+ * @param function : wskaźnik na funkcję PolyAddMove, PolySubMove albo PolyMulMove, którą
+ * będziemy wykonywać.
  */
-void ExecuteArithmeticOp(Stack *stack, unsigned int lineNumber,
-                         Poly (*function)(const Poly *, const Poly *)) {
+void ExecuteArithmeticOp(Stack *stack, unsigned int lineNumber, Poly (*function)(Poly *, Poly *)) {
     size_t size = StackSize(stack);
     if (size < 2) {
         PrintStackUnderflow(lineNumber);
     } else {
         Poly first = Pop(stack);
         Poly second = Pop(stack);
-        Poly result = function(&first, &second);
-        PolyDestroy(&first);
-        PolyDestroy(&second);
-        Push(stack, result);
+        Push(stack, function(&first, &second));
     }
 }
 
@@ -161,14 +159,13 @@ void ExecuteIsEq(Stack *stack, unsigned int lineNumber) {
     if (size < 2) {
         PrintStackUnderflow(lineNumber);
     } else {
-        Poly first = Pop(stack);
-        Poly second = Peek(stack);
+        Poly first = PeekAt(stack, 0);
+        Poly second = PeekAt(stack, 1);
         if (PolyIsEq(&first, &second)) {
             PrintBool(1);
         } else {
             PrintBool(0);
         }
-        Push(stack, first);
     }
 }
 
@@ -182,8 +179,7 @@ void ExecuteNeg(Stack *stack, unsigned int lineNumber) {
         PrintStackUnderflow(lineNumber);
     } else {
         Poly poly = Pop(stack);
-        Push(stack, PolyNeg(&poly));
-        PolyDestroy(&poly);
+        Push(stack, PolyNegMove(&poly));
     }
 }
 
@@ -228,13 +224,107 @@ void ExecuteAt(Stack *stack, poly_coeff_t parameter, unsigned int lineNumber) {
     if (IsEmpty(stack)) {
         PrintStackUnderflow(lineNumber);
     } else {
-        Poly poly = Pop(stack);
+        Poly poly = Peek(stack);
         Poly result = PolyAt(&poly, parameter);
-        PolyDestroy(&poly);
+        Discard(stack);
         Push(stack, result);
     }
 }
 
+/**
+ * Wykonuje polecenie EVAL. Wypisuje wartość wielomianu z wierzchołka stosu, w którym pod
+ * kolejne zmienne wstawiono podane wartości, a pod pozostałe zera. Stos się nie zmienia, ale
+ * skompilowany wielomian zostaje zapamiętany na potrzeby kolejnych poleceń EVAL.
+ * @param stack : stos wielomianów,
+ * @param values : wartości zmiennych,
+ * @param count : liczba wartości,
+ * @param lineNumber : numer linii na której wystąpiło polecenie.
+ */
+void ExecuteEval(Stack *stack, const poly_coeff_t *values, size_t count, unsigned int lineNumber) {
+    if (IsEmpty(stack)) {
+        PrintStackUnderflow(lineNumber);
+    } else {
+        printf("%ld\n", PolyTapeEval(PeekTape(stack), values, count));
+    }
+}
+
+/**
+ * Wykonuje polecenie EVAL_FILE. Wypisuje, po jednej w linii, wartości wielomianu z wierzchołka
+ * stosu we wszystkich punktach z pliku. Stos się nie zmienia. Jeśli pliku nie da się odczytać
+ * albo jest niepoprawny, wypisuje na standardowe wyjście diagnostyczne komunikat o błędzie.
+ * @param stack : stos wielomianów,
+ * @param path : ścieżka pliku z punktami,
+ * @param lineNumber : numer linii na której wystąpiło polecenie.
+ */
+void ExecuteEvalFile(Stack *stack, const char *path, unsigned int lineNumber) {
+    if (IsEmpty(stack)) {
+        PrintStackUnderflow(lineNumber);
+        return;
+    }
+
+    FILE *file = fopen(path, "r");
+    EvalPoints points;
+    bool isCorrect = file != NULL && ReadEvalPoints(file, &points);
+    if (file != NULL) {
+        fclose(file);
+    }
+    if (!isCorrect) {
+        fprintf(stderr, "ERROR %d EVAL FILE WRONG VALUE\n", lineNumber);
+        return;
+    }
+
+    Poly peekPoly = Peek(stack);
+    poly_coeff_t *results = SafeMalloc((points.count + 1) * sizeof(poly_coeff_t));
+    PolyEvalBatch(&peekPoly, (const poly_coeff_t *const *)points.values, points.varCount,
+                  points.count, results);
+    for (size_t i = 0; i < points.count; i++) {
+        printf("%ld\n", results[i]);
+    }
+    free(results);
+    DestroyEvalPoints(&points);
+}
+
+/**
+ * Wykonuje polecenie AT_MANY. Zdejmuje wielomian z wierzchołka stosu i wstawia na stos jego
+ * wartości w kolejnych podanych punktach (patrz polecenie AT), więc wartość w ostatnim punkcie
+ * trafia na wierzchołek.
+ * @param stack : stos wielomianów,
+ * @param values : wartości argumentu,
+ * @param count : liczba wartości,
+ * @param lineNumber : numer linii na której wystąpiło polecenie.
+ */
+void ExecuteAtMany(Stack *stack, const poly_coeff_t *values, size_t count,
+                   unsigned int lineNumber) {
+    if (IsEmpty(stack)) {
+        PrintStackUnderflow(lineNumber);
+    } else {
+        Poly poly = Peek(stack);
+        Poly *results = SafeMalloc(count * sizeof(Poly));
+        PolyAtMany(&poly, count, values, results);
+        Discard(stack);
+        for (size_t i = 0; i < count; i++) {
+            Push(stack, results[i]);
+        }
+        free(results);
+    }
+}
+
+/**
+ * Wykonuje polecenie MOD. Ustawia moduł arytmetyki współczynników i redukuje względem niego
+ * wszystkie wielomiany na stosie. Jeśli moduł nie jest poprawny, wypisuje na standardowe wyjście
+ * diagnostyczne komunikat o błędzie.
+ * @param stack : stos wielomianów,
+ * @param parameter : parametr polecenia,
+ * @param lineNumber : numer linii na której wystąpiło polecenie.
+ */
+void ExecuteMod(Stack *stack, poly_coeff_t parameter, unsigned int lineNumber) {
+    if (!PolySetModulus(parameter)) {
+        fprintf(stderr, "ERROR %d MOD WRONG VALUE\n", lineNumber);
+    } else {
+        TransformAll(stack, PolyReduceMove);
+    }
+}
+
 /**
  * Wykonuje polecenie PRINT.
  * @param stack : stos wielomianów,
@@ -259,8 +349,7 @@ void ExecutePop(Stack *stack, unsigned int lineNumber) {
     if (IsEmpty(stack)) {
         PrintStackUnderflow(lineNumber);
     } else {
-        Poly poly = Pop(stack);
-        PolyDestroy(&poly);
+        Discard(stack);
     }
 }
 
@@ -281,13 +370,13 @@ void ExecuteCommand(Stack *stack, Command command, unsigned int lineNumber) {
     } else if (strcmp(command.name, "CLONE") == 0) {
         ExecuteClone(stack, lineNumber);
     } else if (strcmp(command.name, "ADD") == 0) {
-        ExecuteArithmeticOp(stack, lineNumber, PolyAdd);
+        ExecuteArithmeticOp(stack, lineNumber, PolyAddMove);
     } else if (strcmp(command.name, "MUL") == 0) {
-        ExecuteArithmeticOp(stack, lineNumber, PolyMul);
+        ExecuteArithmeticOp(stack, lineNumber, PolyMulMove);
     } else if (strcmp(command.name, "NEG") == 0) {
         ExecuteNeg(stack, lineNumber);
     } else if (strcmp(command.name, "SUB") == 0) {
-        ExecuteArithmeticOp(stack, lineNumber, PolySub);
+        ExecuteArithmeticOp(stack, lineNumber, PolySubMove);
     } else if (strcmp(command.name, "IS_EQ") == 0) {
         ExecuteIsEq(stack, lineNumber);
     } else if (strcmp(command.name, "DEG") == 0) {
@@ -296,6 +385,19 @@ void ExecuteCommand(Stack *stack, Command command, unsigned int lineNumber) {
         ExecuteDegBy(stack, command.degByParameter, lineNumber);
     } else if (strcmp(command.name, "AT") == 0) {
         ExecuteAt(stack, command.atParameter, lineNumber);
+    } else if (strcmp(command.name, "MOD") == 0) {
+        ExecuteMod(stack, command.modParameter, lineNumber);
+    } else if (strcmp(command.name, "EVAL") == 0) {
+        ExecuteEval(stack, command.valuesParameter.values, command.valuesParameter.count,
+                    lineNumber);
+        free(command.valuesParameter.values);
+    } else if (strcmp(command.name, "AT_MANY") == 0) {
+        ExecuteAtMany(stack, command.valuesParameter.values, command.valuesParameter.count,
+                      lineNumber);
+        free(command.valuesParameter.values);
+    } else if (strcmp(command.name, "EVAL_FILE") == 0) {
+        ExecuteEvalFile(stack, command.evalFilePath, lineNumber);
+        free(command.evalFilePath);
     } else if (strcmp(command.name, "PRINT") == 0) {
         ExecutePrint(stack, lineNumber);
     } else if (strcmp(command.name, "POP") == 0) {
@@ -306,23 +408,30 @@ void ExecuteCommand(Stack *stack, Command command, unsigned int lineNumber) {
 }
 
 /**
- * Wstawia na stos wielomian.
+ * Wstawia na stos wielomian. Jeśli ustawiono moduł, najpierw redukuje współczynniki wielomianu.
  * @param stack : stos wielomianów,
  * @param p : wielomian.
  */
 void PushPoly(Stack *stack, Poly p) {
+    if (PolyGetModulus() != 0) {
+        p = PolyReduceMove(&p);
+    }
     Push(stack, p);
 }
 
 /**
  * Wykonuje dane wejściowe programu. Czyta po linijce danych wejściowych i w zależności od tego,
- * czy była ona poprawna oraz co zawierała podejmuje odpowiednie działanie.
+ * czy była ona poprawna oraz co zawierała podejmuje odpowiednie działanie. Jeśli stos trzyma
+ * wielomiany w regionach, wyniki pośrednie każdej linii powstają w arenie tymczasowej.
  * @param stack : stos wielomianów.
  */
 void ExecuteInput(Stack *stack) {
     unsigned int lineNumber = 1;
     ParsedLine line;
     while (true) {
+        if (stack->useRegions) {
+            PolyArenaBegin();
+        }
         error_t error = ReadOneLineOfInput(&line);
         switch (error) {
             case NO_ERROR:
@@ -347,18 +456,93 @@ void ExecuteInput(Stack *stack) {
             case AT_ERROR:
                 fprintf(stderr, "ERROR %d AT WRONG VALUE\n", lineNumber);
                 break;
+            case MOD_ERROR:
+                fprintf(stderr, "ERROR %d MOD WRONG VALUE\n", lineNumber);
+                break;
+            case EVAL_ERROR:
+                fprintf(stderr, "ERROR %d EVAL WRONG VALUE\n", lineNumber);
+                break;
+            case EVAL_FILE_ERROR:
+                fprintf(stderr, "ERROR %d EVAL FILE WRONG VALUE\n", lineNumber);
+                break;
+            case AT_MANY_ERROR:
+                fprintf(stderr, "ERROR %d AT MANY WRONG VALUE\n", lineNumber);
+                break;
             case ENCOUNTERED_EOF:
+                if (stack->useRegions) {
+                    PolyArenaEnd();
+                }
                 return;
         } // No default label in switch, because we check all possibilities in enum error.
+        if (stack->useRegions) {
+            PolyArenaEnd();
+        }
         lineNumber++;
     }
 }
 
+/**
+ * Wczytuje opcje programu: `-t N` ustawia liczbę wątków używanych przy mnożeniu dużych
+ * wielomianów, `-a` włącza trzymanie wielomianów ze stosu we własnych regionach pamięci, a `-i`
+ * zamienianie ich na współdzielone węzły, dzięki czemu powtarzające się poddrzewa są
+ * przechowywane raz, a IS_EQ nie przechodzi całych drzew. Opcja `-c` włącza trzymanie
+ * wielomianów ze stosu w postaci zwartej, która zajmuje kilka razy mniej pamięci, ale jest
+ * rozpakowywana przy każdym użyciu; wyłącza ona dwie poprzednie.
+ * @param argc : liczba argumentów programu,
+ * @param argv : argumenty programu,
+ * @param useRegions : wskaźnik na zapisanie, czy podano opcję `-a`,
+ * @param useInterning : wskaźnik na zapisanie, czy podano opcję `-i`,
+ * @param useCompression : wskaźnik na zapisanie, czy podano opcję `-c`,
+ * @return Czy opcje były poprawne?
+ */
+bool ReadOptions(int argc, char *argv[], bool *useRegions, bool *useInterning,
+                 bool *useCompression) {
+    *useRegions = false;
+    *useInterning = false;
+    *useCompression = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-a") == 0) {
+            *useRegions = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-i") == 0) {
+            *useInterning = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-c") == 0) {
+            *useCompression = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-t") != 0 || i + 1 == argc) {
+            return false;
+        }
+
+        char *end;
+        errno = 0;
+        long threads = strtol(argv[++i], &end, 10);
+        if (*argv[i] == '\0' || *end != '\0' || errno == ERANGE || threads < 1) {
+            return false;
+        }
+        PolySetThreadCount((size_t)threads);
+    }
+    return true;
+}
+
 /**
  * Główna funkcja wykonująca cały program.
+ * @param argc : liczba argumentów programu,
+ * @param argv : argumenty programu,
+ * @return 0 albo 1, jeśli opcje programu były niepoprawne.
  */
-int main() {
-    Stack *stack = CreateStack();
+int main(int argc, char *argv[]) {
+    bool useRegions, useInterning, useCompression;
+    if (!ReadOptions(argc, argv, &useRegions, &useInterning, &useCompression)) {
+        fprintf(stderr, "Usage: %s [-t THREADS] [-a] [-i] [-c]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Stack *stack = CreateStack(useRegions, useInterning, useCompression);
     ExecuteInput(stack);
     DestroyStack(stack);
+    PolySetThreadCount(1);
 }
\ No newline at end of file
@@ -25,14 +25,37 @@ typedef struct {
      */
     char name[MAX_COMMAND_SIZE];
     /**
-     * Unia przechowująca argument polecenia DEG_BY albo AT.
+     * Unia przechowująca argument polecenia DEG_BY, AT, MOD, EVAL, EVAL_FILE albo AT_MANY.
      */
     union {
         size_t degByParameter;
         poly_coeff_t atParameter;
+        poly_coeff_t modParameter;
+        /**
+         * Lista wartości polecenia EVAL albo AT_MANY. Tablica jest przydzielona funkcją malloc.
+         */
+        struct {
+            poly_coeff_t *values;
+            size_t count;
+        } valuesParameter;
+        /**
+         * Ścieżka pliku z punktami polecenia EVAL_FILE, przydzielona funkcją malloc.
+         */
+        char *evalFilePath;
     };
 } Command;
 
+/**
+ * Struktura przechowująca punkty polecenia EVAL_FILE. Wartości są przechowywane kolumnami:
+ * jedna tablica na zmienną, tak jak oczekuje ich PolyEvalBatch.
+ */
+typedef struct {
+    size_t varCount;       ///< liczba kolumn
+    size_t count;          ///< liczba punktów
+    size_t capacity;       ///< długość tablic kolumn
+    poly_coeff_t **values; ///< kolumny wartości zmiennych
+} EvalPoints;
+
 /**
  * Struktura przechowująca typ linii.
  */
@@ -0,0 +1,240 @@
+/** @file
+ * Implementacja arytmetyki współczynników wielomianów modulo liczba pierwsza oraz mnożenia
+ * tablic reszt transformatą teoretyczno-liczbową.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#include "coeff_ring.h"
+#include "safe_memory_allocation.h"
+
+CoeffRing coeffRing = {.modulus = 0};
+
+/**
+ * Mnoży dwie liczby modulo @p modulus bez użycia redukcji Montgomery'ego.
+ * @param a : liczba @f$a@f$,
+ * @param b : liczba @f$b@f$,
+ * @param modulus : moduł,
+ * @return @f$a \cdot b \bmod modulus@f$.
+ */
+static unsigned long MulMod(unsigned long a, unsigned long b, unsigned long modulus) {
+    return (unsigned long)((unsigned __int128)a * b % modulus);
+}
+
+/**
+ * Podnosi liczbę do potęgi modulo @p modulus.
+ * @param x : podstawa,
+ * @param n : wykładnik,
+ * @param modulus : moduł,
+ * @return @f$x^n \bmod modulus@f$.
+ */
+static unsigned long PowMod(unsigned long x, unsigned long n, unsigned long modulus) {
+    unsigned long result = 1 % modulus;
+    x %= modulus;
+    while (n > 0) {
+        if (n & 1) {
+            result = MulMod(result, x, modulus);
+        }
+        x = MulMod(x, x, modulus);
+        n >>= 1;
+    }
+    return result;
+}
+
+/**
+ * Sprawdza pierwszość liczby deterministycznym testem Millera-Rabina. Dla liczb mniejszych niż
+ * @f$3.3 \cdot 10^{24}@f$ wystarczy dwanaście pierwszych liczb pierwszych jako świadków.
+ * @param n : sprawdzana liczba,
+ * @return Czy @p n jest liczbą pierwszą?
+ */
+static bool IsPrime(unsigned long n) {
+    static const unsigned long witnesses[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    size_t witnessCount = sizeof(witnesses) / sizeof(witnesses[0]);
+
+    if (n < 2) {
+        return false;
+    }
+    for (size_t i = 0; i < witnessCount; i++) {
+        if (n % witnesses[i] == 0) {
+            return n == witnesses[i];
+        }
+    }
+
+    unsigned long d = n - 1;
+    unsigned s = 0;
+    while ((d & 1) == 0) {
+        d >>= 1;
+        s++;
+    }
+
+    for (size_t i = 0; i < witnessCount; i++) {
+        unsigned long x = PowMod(witnesses[i], d, n);
+        if (x == 1 || x == n - 1) {
+            continue;
+        }
+        bool composite = true;
+        for (unsigned r = 1; r < s && composite; r++) {
+            x = MulMod(x, x, n);
+            composite = x != n - 1;
+        }
+        if (composite) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Wyznacza pierwiastek pierwotny z jedynki stopnia @f$2^k@f$, gdzie @f$2^k@f$ jest największą
+ * potęgą dwójki dzielącą @f$p - 1@f$. Dla kolejnych @f$x@f$ liczba @f$w = x^{(p-1)/2^k}@f$ ma
+ * rząd będący potęgą dwójki; szukamy takiej, dla której @f$w^{2^{k-1}} = -1@f$.
+ * @param ring : pierścień z ustawionym modułem i wartością twoAdicity.
+ */
+static void FindRootOfUnity(CoeffRing *ring) {
+    unsigned long p = ring->modulus, odd = (p - 1) >> ring->twoAdicity;
+
+    for (unsigned long x = 2; x < p; x++) {
+        unsigned long w = PowMod(x, odd, p);
+        if (PowMod(w, 1UL << (ring->twoAdicity - 1), p) == p - 1) {
+            ring->root = w;
+            return;
+        }
+    }
+    ring->root = 1;
+    ring->twoAdicity = 0;
+}
+
+bool CoeffRingSetModulus(unsigned long modulus) {
+    if (modulus == 0) {
+        coeffRing = (CoeffRing){.modulus = 0};
+        return true;
+    }
+    if (modulus > COEFF_RING_MAX_MODULUS || !IsPrime(modulus)) {
+        return false;
+    }
+
+    CoeffRing ring = {.modulus = modulus};
+    if (modulus % 2 == 1) {
+        unsigned long inverse = modulus; // Odwrotność modulo 2^3, poprawiana metodą Newtona.
+        for (int i = 0; i < 5; i++) {
+            inverse *= 2 - modulus * inverse;
+        }
+        ring.negInverse = -inverse;
+        unsigned long r = (unsigned long)(((unsigned __int128)1 << 64) % modulus);
+        ring.r2 = MulMod(r, r, modulus);
+
+        for (unsigned long d = modulus - 1; (d & 1) == 0; d >>= 1) {
+            ring.twoAdicity++;
+        }
+        FindRootOfUnity(&ring);
+    }
+
+    coeffRing = ring;
+    return true;
+}
+
+/**
+ * Zamienia resztę na postać Montgomery'ego.
+ * @param x : reszta,
+ * @return @f$x \cdot 2^{64} \bmod p@f$.
+ */
+static inline unsigned long ToMontgomery(unsigned long x) {
+    return MontgomeryReduce((unsigned __int128)x * coeffRing.r2);
+}
+
+/**
+ * Mnoży dwie reszty w postaci Montgomery'ego.
+ * @param a : reszta @f$a@f$ w postaci Montgomery'ego,
+ * @param b : reszta @f$b@f$ w postaci Montgomery'ego,
+ * @return iloczyn w postaci Montgomery'ego.
+ */
+static inline unsigned long MontgomeryMul(unsigned long a, unsigned long b) {
+    return MontgomeryReduce((unsigned __int128)a * b);
+}
+
+/**
+ * Wykonuje w miejscu transformatę teoretyczno-liczbową tablicy reszt w postaci Montgomery'ego.
+ * @param a : tablica długości @p size,
+ * @param size : długość tablicy, potęga dwójki,
+ * @param root : pierwiastek pierwotny z jedynki stopnia @p size w postaci Montgomery'ego.
+ */
+static void Ntt(unsigned long *a, size_t size, unsigned long root) {
+    for (size_t i = 1, j = 0; i < size; i++) {
+        size_t bit = size >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            unsigned long tmp = a[i];
+            a[i] = a[j];
+            a[j] = tmp;
+        }
+    }
+
+    unsigned long *twiddles = SafeMalloc((size / 2 + 1) * sizeof(unsigned long));
+    for (size_t length = 2; length <= size; length <<= 1) {
+        unsigned long step = root;
+        for (size_t k = length; k < size; k <<= 1) {
+            step = MontgomeryMul(step, step);
+        }
+        twiddles[0] = ToMontgomery(1);
+        for (size_t j = 1; j < length / 2; j++) {
+            twiddles[j] = MontgomeryMul(twiddles[j - 1], step);
+        }
+
+        for (size_t i = 0; i < size; i += length) {
+            for (size_t j = 0; j < length / 2; j++) {
+                unsigned long u = a[i + j], v = MontgomeryMul(a[i + j + length / 2], twiddles[j]);
+                a[i + j] = CoeffAdd(u, v);
+                a[i + j + length / 2] = CoeffSub(u, v);
+            }
+        }
+    }
+    free(twiddles);
+}
+
+bool CoeffRingNttMultiply(const unsigned long *a, size_t n, const unsigned long *b, size_t m,
+                          unsigned long *result) {
+    size_t length = n + m - 1, size = 1;
+    unsigned log = 0;
+    while (size < length) {
+        size <<= 1;
+        log++;
+    }
+    if (!CoeffRingIsModular() || coeffRing.negInverse == 0 || log > coeffRing.twoAdicity) {
+        return false;
+    }
+
+    unsigned long *fa = SafeCalloc(size, sizeof(unsigned long));
+    unsigned long *fb = SafeCalloc(size, sizeof(unsigned long));
+    for (size_t i = 0; i < n; i++) {
+        fa[i] = ToMontgomery(a[i]);
+    }
+    for (size_t i = 0; i < m; i++) {
+        fb[i] = ToMontgomery(b[i]);
+    }
+
+    unsigned long p = coeffRing.modulus;
+    unsigned long root = PowMod(coeffRing.root, 1UL << (coeffRing.twoAdicity - log), p);
+    unsigned long inverseRoot = PowMod(root, p - 2, p);
+
+    Ntt(fa, size, ToMontgomery(root));
+    Ntt(fb, size, ToMontgomery(root));
+    for (size_t i = 0; i < size; i++) {
+        fa[i] = MontgomeryMul(fa[i], fb[i]);
+    }
+    Ntt(fa, size, ToMontgomery(inverseRoot));
+
+    // Mnożenie przez zwykłą resztę jednocześnie dzieli przez size i wychodzi z postaci Montgomery'ego.
+    unsigned long scale = PowMod(size % p, p - 2, p);
+    for (size_t i = 0; i < length; i++) {
+        result[i] = MontgomeryMul(fa[i], scale);
+    }
+
+    free(fa);
+    free(fb);
+    return true;
+}
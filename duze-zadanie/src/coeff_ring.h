@@ -0,0 +1,162 @@
+/** @file
+ * Interfejs arytmetyki współczynników wielomianów.
+ *
+ * Domyślnie współczynniki są liczbami typu long, a działania na nich zawijają się modulo
+ * @f$2^{64}@f$. Po ustawieniu modułu pierwszego @f$p@f$ współczynniki są resztami z przedziału
+ * @f$[0, p)@f$, a iloczyny są redukowane metodą Montgomery'ego.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#ifndef POLYNOMIALS_COEFF_RING_H
+#define POLYNOMIALS_COEFF_RING_H
+
+#include "poly.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Największy dopuszczalny moduł. Suma dwóch reszt mieści się wtedy w typie long,
+ * a iloczyn w 124 bitach.
+ */
+#define COEFF_RING_MAX_MODULUS ((1UL << 62) - 1)
+
+/**
+ * Struktura przechowująca aktualny pierścień współczynników.
+ */
+typedef struct {
+    unsigned long modulus;    ///< moduł, 0 oznacza arytmetykę modulo @f$2^{64}@f$
+    unsigned long negInverse; ///< @f$-p^{-1} \bmod 2^{64}@f$ dla nieparzystego modułu
+    unsigned long r2;         ///< @f$2^{128} \bmod p@f$
+    unsigned twoAdicity;      ///< największe @f$k@f$ takie, że @f$2^k@f$ dzieli @f$p - 1@f$
+    unsigned long root;       ///< pierwiastek pierwotny z jedynki stopnia @f$2^k@f$
+} CoeffRing;
+
+/**
+ * Aktualny pierścień współczynników.
+ */
+extern CoeffRing coeffRing;
+
+/**
+ * Ustawia moduł arytmetyki współczynników.
+ * @param modulus : liczba pierwsza nie większa niż COEFF_RING_MAX_MODULUS albo 0, aby wrócić
+ * do arytmetyki modulo @f$2^{64}@f$,
+ * @return false, jeśli moduł jest niepoprawny; wtedy pierścień się nie zmienia.
+ */
+bool CoeffRingSetModulus(unsigned long modulus);
+
+/**
+ * Mnoży dwie tablice reszt szybką transformatą teoretyczno-liczbową (NTT).
+ * @param a : pierwszy czynnik,
+ * @param n : długość pierwszego czynnika,
+ * @param b : drugi czynnik,
+ * @param m : długość drugiego czynnika,
+ * @param result : tablica długości @f$n + m - 1@f$ na iloczyn,
+ * @return false, jeśli moduł nie pozwala na transformatę tej długości; wtedy @p result nie
+ * jest zmieniana.
+ */
+bool CoeffRingNttMultiply(const unsigned long *a, size_t n, const unsigned long *b, size_t m,
+                          unsigned long *result);
+
+/**
+ * Sprawdza, czy współczynniki są liczone modulo liczba pierwsza.
+ * @return Czy ustawiono moduł?
+ */
+static inline bool CoeffRingIsModular(void) {
+    return coeffRing.modulus != 0;
+}
+
+/**
+ * Redukcja Montgomery'ego: dla @f$t < p \cdot 2^{64}@f$ zwraca @f$t \cdot 2^{-64} \bmod p@f$.
+ * @param t : redukowana liczba,
+ * @return reszta z przedziału @f$[0, p)@f$.
+ */
+static inline unsigned long MontgomeryReduce(unsigned __int128 t) {
+    unsigned long m = (unsigned long)t * coeffRing.negInverse;
+    unsigned long result = (unsigned long)((t + (unsigned __int128)m * coeffRing.modulus) >> 64);
+    return result >= coeffRing.modulus ? result - coeffRing.modulus : result;
+}
+
+/**
+ * Zamienia współczynnik na element aktualnego pierścienia.
+ * @param c : współczynnik,
+ * @return @f$c@f$ zredukowane do przedziału @f$[0, p)@f$ albo bez zmian.
+ */
+static inline unsigned long CoeffFromLong(poly_coeff_t c) {
+    if (!CoeffRingIsModular()) {
+        return (unsigned long)c;
+    }
+
+    poly_coeff_t residue = c % (poly_coeff_t)coeffRing.modulus;
+    return (unsigned long)(residue < 0 ? residue + (poly_coeff_t)coeffRing.modulus : residue);
+}
+
+/**
+ * Dodaje dwa elementy pierścienia.
+ * @param a : element @f$a@f$,
+ * @param b : element @f$b@f$,
+ * @return @f$a + b@f$.
+ */
+static inline unsigned long CoeffAdd(unsigned long a, unsigned long b) {
+    unsigned long sum = a + b;
+    return CoeffRingIsModular() && sum >= coeffRing.modulus ? sum - coeffRing.modulus : sum;
+}
+
+/**
+ * Odejmuje dwa elementy pierścienia.
+ * @param a : element @f$a@f$,
+ * @param b : element @f$b@f$,
+ * @return @f$a - b@f$.
+ */
+static inline unsigned long CoeffSub(unsigned long a, unsigned long b) {
+    return CoeffRingIsModular() && a < b ? a + coeffRing.modulus - b : a - b;
+}
+
+/**
+ * Zwraca element przeciwny.
+ * @param a : element @f$a@f$,
+ * @return @f$-a@f$.
+ */
+static inline unsigned long CoeffNeg(unsigned long a) {
+    return CoeffSub(0, a);
+}
+
+/**
+ * Mnoży dwa elementy pierścienia.
+ * @param a : element @f$a@f$,
+ * @param b : element @f$b@f$,
+ * @return @f$a \cdot b@f$.
+ */
+static inline unsigned long CoeffMul(unsigned long a, unsigned long b) {
+    if (!CoeffRingIsModular()) {
+        return a * b;
+    }
+    if (coeffRing.negInverse == 0) { // Moduł 2 nie pozwala na redukcję Montgomery'ego.
+        return (a * b) % coeffRing.modulus;
+    }
+
+    unsigned long reduced = MontgomeryReduce((unsigned __int128)a * b);
+    return MontgomeryReduce((unsigned __int128)reduced * coeffRing.r2);
+}
+
+/**
+ * Podnosi element pierścienia do potęgi, wykorzystując szybkie potęgowanie binarne.
+ * @param x : podstawa @f$x@f$,
+ * @param n : wykładnik @f$n@f$,
+ * @return @f$x^n@f$.
+ */
+static inline unsigned long CoeffPow(unsigned long x, unsigned long n) {
+    unsigned long result = CoeffFromLong(1);
+    while (n > 0) {
+        if (n & 1) {
+            result = CoeffMul(result, x);
+        }
+        x = CoeffMul(x, x);
+        n >>= 1;
+    }
+    return result;
+}
+
+#endif // POLYNOMIALS_COEFF_RING_H
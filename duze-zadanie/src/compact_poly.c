@@ -0,0 +1,173 @@
+/** @file
+ * Implementacja wielomianów w postaci zwartej.
+ *
+ * Wielomian stały zapisujemy jako bajt 0 i współczynnik. Wielomian niestały zapisujemy jako
+ * nagłówek @f$4 \cdot n + w@f$, gdzie @f$n \geq 1@f$ to liczba jednomianów, a @f$w@f$ to kod
+ * szerokości wykładników, po nim @f$n@f$ wykładników tej szerokości, a po nich kolejne
+ * współczynniki jednomianów. Nagłówki i współczynniki są zapisywane w kodzie LEB128, po 7 bitów
+ * na bajt, a współczynniki dodatkowo w kodzie zygzakowym, więc małe liczby ujemne też zajmują
+ * mało bajtów.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#include "compact_poly.h"
+#include "safe_memory_allocation.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Wielomian w postaci zwartej.
+ */
+struct CompactPoly {
+    size_t length;   ///< liczba bajtów zapisu
+    uint8_t bytes[]; ///< zapis wielomianu
+};
+
+/**
+ * Stan zapisu: bufor, do którego dopisujemy kolejne bajty.
+ */
+typedef struct {
+    uint8_t *bytes;  ///< bufor
+    size_t length;   ///< liczba zapisanych bajtów
+    size_t capacity; ///< pojemność bufora
+} CompactWriter;
+
+/**
+ * Zapewnia miejsce na kolejne bajty w buforze.
+ * @param writer : stan zapisu,
+ * @param count : liczba bajtów, które zostaną dopisane.
+ */
+static void Reserve(CompactWriter *writer, size_t count) {
+    if (writer->length + count > writer->capacity) {
+        while (writer->length + count > writer->capacity) {
+            writer->capacity = writer->capacity == 0 ? 64 : 2 * writer->capacity;
+        }
+        writer->bytes = SafeRealloc(writer->bytes, writer->capacity);
+    }
+}
+
+/**
+ * Dopisuje liczbę nieujemną w kodzie LEB128.
+ * @param writer : stan zapisu,
+ * @param value : liczba.
+ */
+static void WriteVarint(CompactWriter *writer, uint64_t value) {
+    Reserve(writer, 10);
+    while (value >= 0x80) {
+        writer->bytes[writer->length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    writer->bytes[writer->length++] = (uint8_t)value;
+}
+
+/**
+ * Odczytuje liczbę nieujemną zapisaną w kodzie LEB128.
+ * @param cursor : wskaźnik na pozycję odczytu, przesuwaną za odczytaną liczbę,
+ * @return odczytana liczba.
+ */
+static uint64_t ReadVarint(const uint8_t **cursor) {
+    uint64_t value = 0;
+    unsigned shift = 0;
+    uint8_t byte;
+    do {
+        byte = *(*cursor)++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return value;
+}
+
+/**
+ * Wyznacza kod najmniejszej szerokości, w której mieszczą się wykładniki jednomianów.
+ * @param p : wielomian niebędący współczynnikiem,
+ * @return 0, 1 albo 2 dla wykładników zapisywanych na 1, 2 albo 4 bajtach.
+ */
+static unsigned ExpWidthCode(const Poly *p) {
+    poly_exp_t maxExp = MonoGetExp(&p->arr[p->size - 1]); // Wykładniki są rosnące.
+    if (maxExp <= UINT8_MAX) {
+        return 0;
+    }
+    return maxExp <= UINT16_MAX ? 1 : 2;
+}
+
+/**
+ * Dopisuje zapis wielomianu.
+ * @param writer : stan zapisu,
+ * @param p : wielomian.
+ */
+static void WritePoly(CompactWriter *writer, const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        uint64_t coeff = (uint64_t)p->coeff;
+        WriteVarint(writer, 0);
+        WriteVarint(writer, coeff << 1 ^ (0 - (coeff >> 63)));
+        return;
+    }
+
+    unsigned code = ExpWidthCode(p);
+    size_t width = (size_t)1 << code;
+    WriteVarint(writer, (uint64_t)p->size << 2 | code);
+    Reserve(writer, p->size * width);
+    for (size_t i = 0; i < p->size; i++) {
+        uint32_t exp = (uint32_t)MonoGetExp(&p->arr[i]);
+        for (size_t byte = 0; byte < width; byte++) {
+            writer->bytes[writer->length++] = (uint8_t)(exp >> (8 * byte));
+        }
+    }
+    for (size_t i = 0; i < p->size; i++) {
+        WritePoly(writer, &p->arr[i].p);
+    }
+}
+
+/**
+ * Odczytuje zapis wielomianu.
+ * @param cursor : wskaźnik na pozycję odczytu, przesuwaną za odczytany wielomian,
+ * @return odczytany wielomian.
+ */
+static Poly ReadPoly(const uint8_t **cursor) {
+    uint64_t header = ReadVarint(cursor);
+    if (header == 0) {
+        uint64_t coeff = ReadVarint(cursor);
+        return PolyFromCoeff((poly_coeff_t)(coeff >> 1 ^ (0 - (coeff & 1))));
+    }
+
+    size_t size = (size_t)(header >> 2), width = (size_t)1 << (header & 3);
+    Mono *monos = SafeMonoArrayAlloc(size);
+    for (size_t i = 0; i < size; i++) {
+        uint32_t exp = 0;
+        for (size_t byte = 0; byte < width; byte++) {
+            exp |= (uint32_t)(*cursor)[byte] << (8 * byte);
+        }
+        *cursor += width;
+        monos[i].exp = (poly_exp_t)exp;
+    }
+    for (size_t i = 0; i < size; i++) {
+        monos[i].p = ReadPoly(cursor);
+    }
+    return (Poly){.size = size, .arr = monos};
+}
+
+CompactPoly *PolyCompress(const Poly *p) {
+    CompactWriter writer = {.bytes = NULL, .length = 0, .capacity = 0};
+    WritePoly(&writer, p);
+
+    CompactPoly *compact = SafeMalloc(sizeof(CompactPoly) + writer.length);
+    compact->length = writer.length;
+    memcpy(compact->bytes, writer.bytes, writer.length);
+    free(writer.bytes);
+
+    return compact;
+}
+
+Poly PolyDecompress(const CompactPoly *compact) {
+    const uint8_t *cursor = compact->bytes;
+    Poly p = ReadPoly(&cursor);
+    assert(cursor == compact->bytes + compact->length);
+    return p;
+}
+
+void CompactPolyDestroy(CompactPoly *compact) {
+    free(compact);
+}
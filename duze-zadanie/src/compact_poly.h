@@ -0,0 +1,47 @@
+/** @file
+ * Interfejs wielomianów w postaci zwartej.
+ *
+ * Postać zwarta to ciąg bajtów zapisujący drzewo wielomianu w kolejności prefiksowej. Każda
+ * tablica jednomianów zapisuje swoje wykładniki w jednej szerokości: 1, 2 albo 4 bajtów,
+ * najmniejszej, w której mieszczą się wszystkie jej wykładniki, a współczynniki i rozmiary
+ * tablic są zapisywane liczbami o zmiennej długości. Wielomian w postaci zwartej zajmuje
+ * kilka razy mniej pamięci niż drzewo, ale przed każdym działaniem trzeba go rozpakować.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#ifndef POLYNOMIALS_COMPACT_POLY_H
+#define POLYNOMIALS_COMPACT_POLY_H
+
+#include "poly.h"
+#include <stddef.h>
+
+/**
+ * Wielomian w postaci zwartej.
+ */
+typedef struct CompactPoly CompactPoly;
+
+/**
+ * Zapisuje wielomian w postaci zwartej. Postać zwarta nie odwołuje się do wielomianu, więc
+ * wielomian można potem usunąć.
+ * @param p : wielomian,
+ * @return wielomian w postaci zwartej, który należy zwolnić funkcją CompactPolyDestroy.
+ */
+CompactPoly *PolyCompress(const Poly *p);
+
+/**
+ * Odtwarza wielomian z postaci zwartej.
+ * @param compact : wielomian w postaci zwartej,
+ * @return wielomian, który należy zwolnić funkcją PolyDestroy.
+ */
+Poly PolyDecompress(const CompactPoly *compact);
+
+/**
+ * Usuwa wielomian w postaci zwartej z pamięci.
+ * @param compact : wielomian w postaci zwartej.
+ */
+void CompactPolyDestroy(CompactPoly *compact);
+
+#endif // POLYNOMIALS_COMPACT_POLY_H
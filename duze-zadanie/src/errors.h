@@ -20,6 +20,10 @@ typedef enum {
     ENCOUNTERED_EOF, // Natrafiliśmy na koniec pliku.
     DEG_BY_ERROR,    // Błąd przy wczytywaniu polecenia DEG_BY.
     AT_ERROR,        // Błąd przy wczytywaniu polecenia AT.
+    MOD_ERROR,       // Błąd przy wczytywaniu polecenia MOD.
+    EVAL_ERROR,      // Błąd przy wczytywaniu polecenia EVAL.
+    EVAL_FILE_ERROR, // Błąd przy wczytywaniu polecenia EVAL_FILE.
+    AT_MANY_ERROR,   // Błąd przy wczytywaniu polecenia AT_MANY.
 } error_t;
 
 #endif // POLYNOMIALS_ERRORS_H
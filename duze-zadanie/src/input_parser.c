@@ -184,11 +184,8 @@ error_t ReadMono(Mono *result) {
         return IgnoreLineAndReturnError(c, INVALID_VALUE);
     }
 
+    // Wczytany współczynnik jest w postaci kanonicznej, więc zero jest stałą zerową.
     *result = MonoFromPoly(&p, (poly_exp_t)exp);
-    if (RecursiveMonoIsZero(result)) {
-        PolyDestroy(&result->p);
-        *result = (Mono){.exp = (int)exp, .p = PolyZero()};
-    }
 
     return NO_ERROR;
 }
@@ -201,20 +198,19 @@ error_t ReadMono(Mono *result) {
  */
 Poly AddMonoToPoly(Poly *p, Mono *m) {
     if (PolyIsZero(&m->p)) {
-        return *p;
+        return PolyClone(p);
     }
     if (PolyIsZero(p)) {
-        poly_coeff_t tmp;
-        if (m->exp == 0 && RecursivePolyIsCoeff(&m->p, &tmp)) {
-            return PolyFromCoeff(tmp);
+        if (m->exp == 0 && PolyIsCoeff(&m->p)) {
+            return m->p;
         } else {
-            Poly polyResult = {.size = 1, .arr = SafeMalloc(sizeof(Mono))};
+            Poly polyResult = {.size = 1, .arr = SafeMonoArrayAlloc(1)};
             polyResult.arr[0] = *m;
             return polyResult;
         }
     }
 
-    Poly tmpPoly = {.size = 1, .arr = SafeMalloc(sizeof(Mono))};
+    Poly tmpPoly = {.size = 1, .arr = SafeMonoArrayAlloc(1)};
     tmpPoly.arr[0] = *m;
     Poly result = PolyAdd(p, &tmpPoly);
     PolyDestroy(&tmpPoly);
@@ -316,7 +312,7 @@ error_t ReadAtParameter(poly_coeff_t *parameter) {
         tmp = (tmp * 10) + ((unsigned)c - '0');
         if (tmp > LONG_MAX) {
             if (tmp - 1 == LONG_MAX && isNegative) {
-                *parameter = -1 * (signed)tmp;
+                *parameter = (poly_coeff_t)(0 - tmp);
                 return NO_ERROR;
             }
             return IgnoreLineAndReturnError(c, AT_ERROR);
@@ -328,7 +324,7 @@ error_t ReadAtParameter(poly_coeff_t *parameter) {
         return IgnoreLineAndReturnError(c, AT_ERROR);
     }
 
-    *parameter = (signed)tmp;
+    *parameter = (poly_coeff_t)tmp;
 
     if (isNegative) {
         if (*parameter == 0) {
@@ -340,6 +336,208 @@ error_t ReadAtParameter(poly_coeff_t *parameter) {
     return NO_ERROR;
 }
 
+/**
+ * Wczytuje parametr polecenia MOD.
+ * @param *parameter : wskaźnik na zapisanie parametru,
+ * @return : kod błędu.
+ */
+error_t ReadModParameter(poly_coeff_t *parameter) {
+    unsigned long tmp = 0;
+    int c = getchar();
+
+    if (!isdigit(c)) {
+        return IgnoreLineAndReturnError(c, MOD_ERROR);
+    }
+
+    while (isdigit(c)) {
+        tmp = (tmp * 10) + ((unsigned)c - '0');
+        if (tmp > LONG_MAX) {
+            return IgnoreLineAndReturnError(c, MOD_ERROR);
+        }
+        c = getchar();
+    }
+
+    if (c != EOF && c != '\n') {
+        return IgnoreLineAndReturnError(c, MOD_ERROR);
+    }
+
+    *parameter = (poly_coeff_t)tmp;
+
+    return NO_ERROR;
+}
+
+/**
+ * Wczytuje jedną wartość z listy wartości polecenia EVAL albo AT_MANY albo z punktu polecenia
+ * EVAL_FILE: liczbę typu long zakończoną spacją, końcem linii albo końcem pliku.
+ * @param input : plik, z którego czytamy,
+ * @param *value : wskaźnik na zapisanie wartości,
+ * @param *next : wskaźnik na zapisanie znaku kończącego wartość,
+ * @return Czy wartość była poprawna?
+ */
+bool ReadEvalValue(FILE *input, poly_coeff_t *value, int *next) {
+    unsigned long tmp = 0;
+    bool isNegative = false;
+    unsigned long limit = (unsigned long)LONG_MAX;
+    int c = getc(input);
+
+    if (c == '-') {
+        isNegative = true;
+        limit++;
+        c = getc(input);
+    }
+    if (!isdigit(c)) {
+        *next = c;
+        return false;
+    }
+
+    while (isdigit(c)) {
+        if (tmp > (limit - ((unsigned)c - '0')) / 10) {
+            *next = c;
+            return false;
+        }
+        tmp = (tmp * 10) + ((unsigned)c - '0');
+        c = getc(input);
+    }
+
+    *next = c;
+    if (c != EOF && c != '\n' && c != ' ') {
+        return false;
+    }
+    *value = isNegative ? (poly_coeff_t)(0 - tmp) : (poly_coeff_t)tmp;
+
+    return true;
+}
+
+/**
+ * Wczytuje parametr polecenia EVAL albo AT_MANY: niepustą listę wartości oddzielonych spacjami.
+ * @param *parameter : wskaźnik na polecenie, na którym zapisujemy parametr,
+ * @param error : kod błędu zwracany dla niepoprawnej listy,
+ * @return : kod błędu.
+ */
+error_t ReadValuesParameter(Command *parameter, error_t error) {
+    size_t capacity = 4;
+    poly_coeff_t *values = SafeMalloc(capacity * sizeof(poly_coeff_t));
+    size_t count = 0;
+    int c;
+
+    do {
+        if (count == capacity) {
+            capacity *= 2;
+            values = SafeRealloc(values, capacity * sizeof(poly_coeff_t));
+        }
+        if (!ReadEvalValue(stdin, &values[count++], &c)) {
+            free(values);
+            return IgnoreLineAndReturnError(c, error);
+        }
+    } while (c == ' ');
+
+    parameter->valuesParameter.values = values;
+    parameter->valuesParameter.count = count;
+
+    return NO_ERROR;
+}
+
+/**
+ * Dopisuje do zbioru punktów nowy punkt, którego wszystkie współrzędne są zerami.
+ * @param points : zbiór punktów.
+ */
+void AddEvalPoint(EvalPoints *points) {
+    if (points->count == points->capacity) {
+        points->capacity = points->capacity == 0 ? 64 : 2 * points->capacity;
+        for (size_t var = 0; var < points->varCount; var++) {
+            points->values[var] =
+                SafeRealloc(points->values[var], points->capacity * sizeof(poly_coeff_t));
+        }
+    }
+    for (size_t var = 0; var < points->varCount; var++) {
+        points->values[var][points->count] = 0;
+    }
+    points->count++;
+}
+
+/**
+ * Ustawia współrzędną ostatniego punktu zbioru, w razie potrzeby dodając zerowe kolumny
+ * wartości kolejnych zmiennych.
+ * @param points : niepusty zbiór punktów,
+ * @param var : indeks zmiennej,
+ * @param value : wartość zmiennej.
+ */
+void SetEvalPointValue(EvalPoints *points, size_t var, poly_coeff_t value) {
+    while (var >= points->varCount) {
+        points->values =
+            SafeRealloc(points->values, (points->varCount + 1) * sizeof(poly_coeff_t *));
+        points->values[points->varCount] = SafeMalloc(points->capacity * sizeof(poly_coeff_t));
+        memset(points->values[points->varCount], 0, points->capacity * sizeof(poly_coeff_t));
+        points->varCount++;
+    }
+    points->values[var][points->count - 1] = value;
+}
+
+void DestroyEvalPoints(EvalPoints *points) {
+    for (size_t var = 0; var < points->varCount; var++) {
+        free(points->values[var]);
+    }
+    free(points->values);
+}
+
+bool ReadEvalPoints(FILE *file, EvalPoints *points) {
+    *points = (EvalPoints){.varCount = 0, .count = 0, .capacity = 0, .values = NULL};
+    int c = getc(file);
+
+    while (c != EOF) {
+        if (c == '\n') {
+            c = getc(file);
+            continue;
+        }
+        ungetc(c, file);
+        AddEvalPoint(points);
+        size_t var = 0;
+        do {
+            poly_coeff_t value;
+            if (!ReadEvalValue(file, &value, &c)) {
+                DestroyEvalPoints(points);
+                return false;
+            }
+            SetEvalPointValue(points, var++, value);
+        } while (c == ' ');
+        if (c == '\n') {
+            c = getc(file);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Wczytuje parametr polecenia EVAL_FILE: niepustą ścieżkę pliku z punktami, sięgającą do końca
+ * linii.
+ * @param *command : wskaźnik na polecenie, na którym zapisujemy parametr,
+ * @return : kod błędu.
+ */
+error_t ReadEvalFileParameter(Command *command) {
+    size_t capacity = 64, length = 0;
+    char *path = SafeMalloc(capacity);
+    int c = getchar();
+
+    while (c != '\n' && c != EOF && c != '\0') {
+        if (length + 1 == capacity) {
+            capacity *= 2;
+            path = SafeRealloc(path, capacity);
+        }
+        path[length++] = (char)c;
+        c = getchar();
+    }
+    path[length] = '\0';
+
+    if (length == 0 || c == '\0') {
+        free(path);
+        return IgnoreLineAndReturnError(c, EVAL_FILE_ERROR);
+    }
+    command->evalFilePath = path;
+
+    return NO_ERROR;
+}
+
 /**
  * Wczytuje słowo.
  * @param *command : wskaźnik na polecenie, na którym zapisujemy słowo.
@@ -365,6 +563,14 @@ error_t ReadWord(Command *command) {
                 return DEG_BY_ERROR;
             } else if (strcmp(command->name, "AT") == 0) {
                 return AT_ERROR;
+            } else if (strcmp(command->name, "MOD") == 0) {
+                return MOD_ERROR;
+            } else if (strcmp(command->name, "EVAL") == 0) {
+                return EVAL_ERROR;
+            } else if (strcmp(command->name, "AT_MANY") == 0) {
+                return AT_MANY_ERROR;
+            } else if (strcmp(command->name, "EVAL_FILE") == 0) {
+                return EVAL_FILE_ERROR;
             }
             return INVALID_VALUE;
         }
@@ -393,6 +599,14 @@ error_t ReadCommand(Command *command) {
                 return ReadDegByParameter(&command->degByParameter);
             } else if (strcmp(command->name, "AT") == 0) {
                 return ReadAtParameter(&command->atParameter);
+            } else if (strcmp(command->name, "MOD") == 0) {
+                return ReadModParameter(&command->modParameter);
+            } else if (strcmp(command->name, "EVAL") == 0) {
+                return ReadValuesParameter(command, EVAL_ERROR);
+            } else if (strcmp(command->name, "AT_MANY") == 0) {
+                return ReadValuesParameter(command, AT_MANY_ERROR);
+            } else if (strcmp(command->name, "EVAL_FILE") == 0) {
+                return ReadEvalFileParameter(command);
             } else {
                 return IgnoreLineAndReturnError(c, INVALID_VALUE);
             }
@@ -403,6 +617,18 @@ error_t ReadCommand(Command *command) {
         if (strcmp(command->name, "AT") == 0) {
             return AT_ERROR;
         }
+        if (strcmp(command->name, "MOD") == 0) {
+            return MOD_ERROR;
+        }
+        if (strcmp(command->name, "EVAL") == 0) {
+            return EVAL_ERROR;
+        }
+        if (strcmp(command->name, "AT_MANY") == 0) {
+            return AT_MANY_ERROR;
+        }
+        if (strcmp(command->name, "EVAL_FILE") == 0) {
+            return EVAL_FILE_ERROR;
+        }
         if (c == '\n' || c == EOF) {
             return NO_ERROR;
         }
@@ -10,7 +10,24 @@
 #define POLYNOMIALS_INPUT_PARSER_H
 
 #include "calc.h"
+#include <stdio.h>
 
 error_t ReadOneLineOfInput(ParsedLine *line);
 
+/**
+ * Wczytuje z pliku punkty polecenia EVAL_FILE. Każda niepusta linia pliku to jeden punkt:
+ * wartości kolejnych zmiennych oddzielone spacjami. Brakujące współrzędne punktu są zerami.
+ * @param file : plik z punktami,
+ * @param points : wskaźnik na zapisanie punktów; po udanym wczytaniu należy je zwolnić funkcją
+ * DestroyEvalPoints,
+ * @return Czy plik był poprawny?
+ */
+bool ReadEvalPoints(FILE *file, EvalPoints *points);
+
+/**
+ * Zwalnia pamięć zajmowaną przez punkty polecenia EVAL_FILE.
+ * @param points : punkty.
+ */
+void DestroyEvalPoints(EvalPoints *points);
+
 #endif // POLYNOMIALS_INPUT_PARSER_H
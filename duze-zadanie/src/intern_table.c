@@ -0,0 +1,174 @@
+/** @file
+ * Implementacja tablicy współdzielonych węzłów wielomianów.
+ *
+ * Tablica jest tablicą z haszowaniem otwartym i liniowym próbkowaniem. Ponieważ współczynniki
+ * węzła są liczbami albo współdzielonymi węzłami, skrót i porównanie węzłów są płytkie:
+ * wystarczy porównać wykładniki, liczby i wskaźniki na tablice współczynników.
+ *
+ * Liczniki odwołań są zmniejszane bez blokady, także przez wątki puli. Węzeł, którego licznik
+ * spadł do zera, pozostaje w tablicy do wywołania InternTableRemove, ale wyszukiwanie go pomija,
+ * więc nie może zostać przywrócony.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#include "intern_table.h"
+#include "safe_memory_allocation.h"
+#include <pthread.h>
+
+/**
+ * Początkowa liczba pozycji tablicy.
+ */
+#define INTERN_TABLE_INITIAL_CAPACITY 1024
+
+/**
+ * Pozycja tablicy.
+ */
+typedef struct {
+    Mono *monos;  ///< węzeł albo NULL dla pustej pozycji
+    size_t count; ///< liczba jednomianów węzła
+    size_t hash;  ///< skrót węzła
+} InternEntry;
+
+/**
+ * Tablica współdzielonych węzłów.
+ */
+static struct {
+    pthread_mutex_t lock; ///< blokada chroniąca tablicę
+    InternEntry *entries; ///< pozycje tablicy
+    size_t capacity;      ///< liczba pozycji, potęga dwójki
+    size_t size;          ///< liczba zajętych pozycji
+} table = {.lock = PTHREAD_MUTEX_INITIALIZER, .entries = NULL, .capacity = 0, .size = 0};
+
+/**
+ * Zwraca klucz współczynnika jednomianu węzła: liczbę albo adres współdzielonego węzła.
+ * @param p : współczynnik jednomianu,
+ * @return klucz współczynnika.
+ */
+static inline uint64_t CoeffKey(const Poly *p) {
+    return PolyIsCoeff(p) ? (uint64_t)p->coeff : (uint64_t)(uintptr_t)p->arr;
+}
+
+/**
+ * Liczy skrót węzła.
+ * @param count : liczba jednomianów,
+ * @param monos : tablica jednomianów,
+ * @return skrót.
+ */
+static size_t HashMonos(size_t count, const Mono *monos) {
+    uint64_t hash = HashMix(count);
+    for (size_t i = 0; i < count; i++) {
+        hash = HashMix(hash ^ (uint64_t)(uint32_t)monos[i].exp);
+        hash = HashMix(hash ^ CoeffKey(&monos[i].p));
+    }
+    return (size_t)hash;
+}
+
+/**
+ * Sprawdza, czy węzły mają tę samą zawartość.
+ * @param count : liczba jednomianów pierwszego węzła,
+ * @param monos : pierwszy węzeł,
+ * @param entry : pozycja z drugim węzłem,
+ * @return Czy węzły są równe?
+ */
+static bool EntryEquals(size_t count, const Mono *monos, const InternEntry *entry) {
+    if (entry->count != count) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const Poly *p = &monos[i].p, *q = &entry->monos[i].p;
+        if (monos[i].exp != entry->monos[i].exp || PolyIsCoeff(p) != PolyIsCoeff(q) ||
+            CoeffKey(p) != CoeffKey(q)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Wstawia pozycję na pierwsze wolne miejsce jej ciągu próbkowania.
+ * @param entries : pozycje tablicy,
+ * @param capacity : liczba pozycji,
+ * @param entry : wstawiana pozycja.
+ */
+static void PlaceEntry(InternEntry *entries, size_t capacity, InternEntry entry) {
+    size_t i = entry.hash & (capacity - 1);
+    while (entries[i].monos != NULL) {
+        i = (i + 1) & (capacity - 1);
+    }
+    entries[i] = entry;
+}
+
+/**
+ * Podwaja liczbę pozycji tablicy.
+ */
+static void Grow(void) {
+    size_t capacity = table.capacity == 0 ? INTERN_TABLE_INITIAL_CAPACITY : 2 * table.capacity;
+    InternEntry *entries = SafeMalloc(capacity * sizeof(InternEntry));
+    for (size_t i = 0; i < capacity; i++) {
+        entries[i].monos = NULL;
+    }
+    for (size_t i = 0; i < table.capacity; i++) {
+        if (table.entries[i].monos != NULL) {
+            PlaceEntry(entries, capacity, table.entries[i]);
+        }
+    }
+    free(table.entries);
+    table.entries = entries;
+    table.capacity = capacity;
+}
+
+Mono *InternTableInsert(size_t count, Mono *monos) {
+    size_t hash = HashMonos(count, monos);
+
+    pthread_mutex_lock(&table.lock);
+    if (table.capacity == 0) {
+        Grow();
+    }
+    for (size_t i = hash & (table.capacity - 1); table.entries[i].monos != NULL;
+         i = (i + 1) & (table.capacity - 1)) {
+        InternEntry *entry = &table.entries[i];
+        if (entry->hash == hash && EntryEquals(count, monos, entry) &&
+            MonoArrayTryRetain(entry->monos)) {
+            pthread_mutex_unlock(&table.lock);
+            return entry->monos;
+        }
+    }
+
+    if (2 * (table.size + 1) > table.capacity) {
+        Grow();
+    }
+    MonoArrayMarkInterned(monos);
+    PlaceEntry(table.entries, table.capacity,
+               (InternEntry){.monos = monos, .count = count, .hash = hash});
+    table.size++;
+    pthread_mutex_unlock(&table.lock);
+
+    return monos;
+}
+
+void InternTableRemove(size_t count, const Mono *monos) {
+    size_t hash = HashMonos(count, monos);
+
+    pthread_mutex_lock(&table.lock);
+    size_t mask = table.capacity - 1;
+    size_t i = hash & mask;
+    while (table.entries[i].monos != monos) {
+        i = (i + 1) & mask;
+    }
+
+    // Przesuwamy wstecz pozycje z dalszej części ciągu, aby nie pozostawić w nim dziury.
+    size_t hole = i;
+    for (size_t j = (i + 1) & mask; table.entries[j].monos != NULL; j = (j + 1) & mask) {
+        size_t home = table.entries[j].hash & mask;
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            table.entries[hole] = table.entries[j];
+            hole = j;
+        }
+    }
+    table.entries[hole].monos = NULL;
+    table.size--;
+    pthread_mutex_unlock(&table.lock);
+}
@@ -0,0 +1,52 @@
+/** @file
+ * Interfejs tablicy współdzielonych węzłów wielomianów (ang. hash-consing).
+ *
+ * Węzeł to tablica jednomianów, których współczynniki są liczbami albo współdzielonymi węzłami.
+ * Tablica przechowuje co najwyżej jeden żywy węzeł o danej zawartości, więc dwa współdzielone
+ * węzły są równe wtedy i tylko wtedy, gdy są tą samą tablicą. Licznik odwołań węzła jest
+ * przechowywany w nagłówku tablicy (patrz MonoArrayMarkInterned).
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#ifndef POLYNOMIALS_INTERN_TABLE_H
+#define POLYNOMIALS_INTERN_TABLE_H
+
+#include "poly.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Miesza bity liczby (funkcja końcowa generatora SplitMix64). Służy do liczenia skrótów
+ * wielomianów.
+ * @param x : liczba,
+ * @return wymieszana liczba.
+ */
+static inline uint64_t HashMix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Wyszukuje w tablicy węzeł o zawartości @p monos. Jeśli taki węzeł istnieje, zwiększa jego
+ * licznik odwołań i go zwraca; wywołujący pozostaje wtedy właścicielem @p monos. W przeciwnym
+ * razie oznacza @p monos jako współdzielony węzeł, wstawia go do tablicy i zwraca.
+ * @param count : liczba jednomianów,
+ * @param monos : tablica jednomianów spoza areny, posortowana po wykładnikach, której
+ * współczynniki są liczbami albo współdzielonymi węzłami,
+ * @return współdzielony węzeł równy @p monos.
+ */
+Mono *InternTableInsert(size_t count, Mono *monos);
+
+/**
+ * Usuwa z tablicy węzeł, którego licznik odwołań spadł do zera. Po wywołaniu węzeł można
+ * zwolnić.
+ * @param count : liczba jednomianów węzła,
+ * @param monos : współdzielony węzeł.
+ */
+void InternTableRemove(size_t count, const Mono *monos);
+
+#endif // POLYNOMIALS_INTERN_TABLE_H
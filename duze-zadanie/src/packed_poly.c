@@ -0,0 +1,345 @@
+/** @file
+ * Implementacja wielomianów w postaci spakowanej.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#include "packed_poly.h"
+#include "coeff_ring.h"
+#include "safe_memory_allocation.h"
+#include <stdlib.h>
+
+/**
+ * Największa szerokość pola wykładnika. Przy niej największy wykładnik mieszczący się w polu
+ * obok bitu strażniczego jest równy największej wartości typu poly_exp_t.
+ */
+#define PACKED_MAX_FIELD_BITS 32
+
+/**
+ * Zwraca szerokość pola wykładnika jednej zmiennej.
+ * @param varCount : liczba zmiennych, dodatnia,
+ * @return szerokość pola w bitach.
+ */
+static inline unsigned FieldBits(size_t varCount) {
+    unsigned bits = (unsigned)(64 / varCount);
+    return bits < PACKED_MAX_FIELD_BITS ? bits : PACKED_MAX_FIELD_BITS;
+}
+
+/**
+ * Zwraca przesunięcie pola wykładnika zmiennej.
+ * @param varCount : liczba zmiennych, dodatnia,
+ * @param var : indeks zmiennej,
+ * @return numer najmłodszego bitu pola.
+ */
+static inline unsigned FieldShift(size_t varCount, size_t var) {
+    return (unsigned)(varCount - 1 - var) * FieldBits(varCount);
+}
+
+/**
+ * Zwraca wykładnik zmiennej zapisany w spakowanym wektorze wykładników.
+ * @param exp : spakowany wektor wykładników,
+ * @param varCount : liczba zmiennych, dodatnia,
+ * @param var : indeks zmiennej,
+ * @return wykładnik zmiennej.
+ */
+static inline poly_exp_t FieldValue(uint64_t exp, size_t varCount, size_t var) {
+    return (poly_exp_t)((exp >> FieldShift(varCount, var)) &
+                        ((UINT64_C(1) << FieldBits(varCount)) - 1));
+}
+
+/**
+ * Zwraca maskę bitów strażniczych wszystkich pól.
+ * @param varCount : liczba zmiennych,
+ * @return maska bitów strażniczych.
+ */
+static uint64_t GuardMask(size_t varCount) {
+    uint64_t mask = 0;
+    for (size_t var = 0; var < varCount; var++) {
+        mask |= UINT64_C(1) << (FieldShift(varCount, var) + FieldBits(varCount) - 1);
+    }
+    return mask;
+}
+
+/**
+ * Zwraca liczbę niezerowych współczynników liczbowych w drzewie wielomianu.
+ * @param p : wielomian,
+ * @return liczba jednomianów postaci spakowanej.
+ */
+static size_t LeafCount(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return PolyIsZero(p) ? 0 : 1;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        count += LeafCount(&p->arr[i].p);
+    }
+    return count;
+}
+
+/**
+ * Spłaszcza drzewo wielomianu, dopisując jednomiany w kolejności drzewa, czyli rosnąco po
+ * spakowanych wykładnikach.
+ * @param p : wielomian,
+ * @param var : indeks zmiennej głównej wielomianu @p p,
+ * @param prefix : spakowane wykładniki zmiennych o mniejszych indeksach,
+ * @param result : wielomian spakowany, do którego dopisujemy jednomiany,
+ * @return false, jeśli wielomian ma za dużo zmiennych albo za duży wykładnik.
+ */
+static bool Flatten(const Poly *p, size_t var, uint64_t prefix, PackedPoly *result) {
+    if (PolyIsCoeff(p)) {
+        if (!PolyIsZero(p)) {
+            result->monos[result->size++] = (PackedMono){.exp = prefix, .coeff = p->coeff};
+        }
+        return true;
+    }
+    if (var == result->varCount) {
+        return false;
+    }
+
+    uint64_t limit = UINT64_C(1) << (FieldBits(result->varCount) - 1);
+    for (size_t i = 0; i < p->size; i++) {
+        uint64_t exp = (uint64_t)MonoGetExp(&p->arr[i]);
+        if (exp >= limit ||
+            !Flatten(&p->arr[i].p, var + 1, prefix | exp << FieldShift(result->varCount, var),
+                     result)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PackedPolyFromPoly(const Poly *p, size_t varCount, PackedPoly *result) {
+    assert(varCount > 0 && varCount <= 64);
+
+    PackedPoly packed = {.varCount = varCount, .size = 0};
+    packed.monos = SafeMalloc((LeafCount(p) + 1) * sizeof(PackedMono));
+    if (!Flatten(p, 0, 0, &packed)) {
+        free(packed.monos);
+        return false;
+    }
+    *result = packed;
+    return true;
+}
+
+/**
+ * Odtwarza drzewo wielomianu z ciągu jednomianów spakowanych, których wykładniki zmiennych
+ * o indeksach mniejszych niż @p var są równe.
+ * @param monos : jednomiany posortowane rosnąco po spakowanych wykładnikach,
+ * @param count : liczba jednomianów, dodatnia,
+ * @param var : indeks zmiennej głównej tworzonego wielomianu,
+ * @param varCount : liczba zmiennych postaci spakowanej,
+ * @return wielomian będący sumą jednomianów.
+ */
+static Poly Unflatten(const PackedMono *monos, size_t count, size_t var, size_t varCount) {
+    if (var == varCount) {
+        assert(count == 1);
+        return PolyFromCoeff(monos[0].coeff);
+    }
+
+    size_t groups = 0;
+    for (size_t i = 0; i < count; i++) {
+        groups += i == 0 || FieldValue(monos[i].exp, varCount, var) !=
+                                FieldValue(monos[i - 1].exp, varCount, var);
+    }
+
+    Mono *arr = SafeMonoArrayAlloc(groups);
+    size_t arrI = 0;
+    for (size_t begin = 0, end; begin < count; begin = end) {
+        poly_exp_t exp = FieldValue(monos[begin].exp, varCount, var);
+        for (end = begin + 1; end < count && FieldValue(monos[end].exp, varCount, var) == exp;
+             end++) {
+        }
+        Poly child = Unflatten(monos + begin, end - begin, var + 1, varCount);
+        arr[arrI++] = MonoFromPoly(&child, exp);
+    }
+
+    // Pojedynczy jednomian o wykładniku 0 ze stałym współczynnikiem to ten współczynnik.
+    if (groups == 1 && MonoGetExp(&arr[0]) == 0 && PolyIsCoeff(&arr[0].p)) {
+        Poly coeff = arr[0].p;
+        MonoArrayFree(arr);
+        return coeff;
+    }
+    return (Poly){.size = groups, .arr = arr};
+}
+
+Poly PackedPolyToPoly(const PackedPoly *p) {
+    if (p->size == 0) {
+        return PolyZero();
+    }
+    return Unflatten(p->monos, p->size, 0, p->varCount);
+}
+
+PackedPoly PackedPolyAdd(const PackedPoly *p, const PackedPoly *q) {
+    assert(p->varCount == q->varCount);
+
+    PackedPoly sum = {.varCount = p->varCount, .size = 0};
+    sum.monos = SafeMalloc((p->size + q->size + 1) * sizeof(PackedMono));
+    size_t i = 0, j = 0;
+    while (i < p->size || j < q->size) {
+        if (j == q->size || (i < p->size && p->monos[i].exp < q->monos[j].exp)) {
+            sum.monos[sum.size++] = p->monos[i++];
+        } else if (i == p->size || q->monos[j].exp < p->monos[i].exp) {
+            sum.monos[sum.size++] = q->monos[j++];
+        } else {
+            unsigned long coeff =
+                CoeffAdd((unsigned long)p->monos[i].coeff, (unsigned long)q->monos[j].coeff);
+            if (coeff != 0) {
+                sum.monos[sum.size++] =
+                    (PackedMono){.exp = p->monos[i].exp, .coeff = (poly_coeff_t)coeff};
+            }
+            i++;
+            j++;
+        }
+    }
+    return sum;
+}
+
+/**
+ * Pozycja kopca w mnożeniu: iloczyn jednomianu pierwszego czynnika z kolejnym jednomianem
+ * drugiego czynnika.
+ */
+typedef struct {
+    uint64_t exp; ///< spakowany wykładnik iloczynu
+    size_t i;     ///< indeks jednomianu pierwszego czynnika
+    size_t j;     ///< indeks jednomianu drugiego czynnika
+} PackedHeapItem;
+
+/**
+ * Przywraca własność kopca minimalnego, przesuwając pozycję w dół.
+ * @param heap : kopiec,
+ * @param size : rozmiar kopca,
+ * @param k : indeks przesuwanej pozycji.
+ */
+static void SiftDown(PackedHeapItem *heap, size_t size, size_t k) {
+    PackedHeapItem item = heap[k];
+    while (2 * k + 1 < size) {
+        size_t child = 2 * k + 1;
+        if (child + 1 < size && heap[child + 1].exp < heap[child].exp) {
+            child++;
+        }
+        if (item.exp <= heap[child].exp) {
+            break;
+        }
+        heap[k] = heap[child];
+        k = child;
+    }
+    heap[k] = item;
+}
+
+bool PackedPolyMul(const PackedPoly *p, const PackedPoly *q, PackedPoly *result) {
+    assert(p->varCount == q->varCount);
+    if (p->size > q->size) {
+        const PackedPoly *tmp = p;
+        p = q;
+        q = tmp;
+    }
+
+    PackedPoly product = {.varCount = p->varCount, .size = 0};
+    if (p->size == 0) {
+        product.monos = SafeMalloc(sizeof(PackedMono));
+        *result = product;
+        return true;
+    }
+
+    // Pola nie przenoszą się na sąsiednie, bo ich najstarsze bity są zerami, więc przepełnienie
+    // wystarczy sprawdzić dla największych wykładników każdej zmiennej.
+    uint64_t guard = GuardMask(p->varCount);
+    for (size_t var = 0; var < p->varCount; var++) {
+        poly_exp_t pMax = 0, qMax = 0;
+        for (size_t i = 0; i < p->size; i++) {
+            poly_exp_t exp = FieldValue(p->monos[i].exp, p->varCount, var);
+            pMax = exp > pMax ? exp : pMax;
+        }
+        for (size_t j = 0; j < q->size; j++) {
+            poly_exp_t exp = FieldValue(q->monos[j].exp, q->varCount, var);
+            qMax = exp > qMax ? exp : qMax;
+        }
+        uint64_t sum = ((uint64_t)pMax + (uint64_t)qMax) << FieldShift(p->varCount, var);
+        if ((sum & guard) != 0) {
+            return false;
+        }
+    }
+
+    // Algorytm Johnsona: kopiec trzyma dla każdego jednomianu p najmniejszy nieprzetworzony
+    // iloczyn z jednomianem q, więc iloczyny wychodzą z kopca rosnąco po wykładnikach.
+    size_t capacity = p->size + q->size;
+    product.monos = SafeMalloc(capacity * sizeof(PackedMono));
+    PackedHeapItem *heap = SafeMalloc(p->size * sizeof(PackedHeapItem));
+    for (size_t i = 0; i < p->size; i++) {
+        heap[i] = (PackedHeapItem){.exp = p->monos[i].exp + q->monos[0].exp, .i = i, .j = 0};
+    }
+    size_t heapSize = p->size;
+    for (size_t k = heapSize / 2; k-- > 0;) {
+        SiftDown(heap, heapSize, k);
+    }
+
+    while (heapSize > 0) {
+        uint64_t exp = heap[0].exp;
+        unsigned long coeff = 0;
+        while (heapSize > 0 && heap[0].exp == exp) {
+            PackedHeapItem *top = &heap[0];
+            coeff = CoeffAdd(coeff, CoeffMul((unsigned long)p->monos[top->i].coeff,
+                                             (unsigned long)q->monos[top->j].coeff));
+            if (++top->j < q->size) {
+                top->exp = p->monos[top->i].exp + q->monos[top->j].exp;
+            } else {
+                heap[0] = heap[--heapSize];
+            }
+            SiftDown(heap, heapSize, 0);
+        }
+        if (coeff != 0) {
+            if (product.size == capacity) {
+                capacity *= 2;
+                product.monos = SafeRealloc(product.monos, capacity * sizeof(PackedMono));
+            }
+            product.monos[product.size++] = (PackedMono){.exp = exp, .coeff = (poly_coeff_t)coeff};
+        }
+    }
+    free(heap);
+
+    *result = product;
+    return true;
+}
+
+poly_coeff_t PackedPolyEval(const PackedPoly *p, const poly_coeff_t *xs, size_t varCount) {
+    if (p->size == 0) {
+        return 0;
+    }
+
+    // prefix[v] to iloczyn potęg zmiennych o indeksach mniejszych niż v. Kolejne jednomiany
+    // często mają wspólne wykładniki najstarszych zmiennych, więc przeliczamy tylko resztę.
+    unsigned long *prefix = SafeMalloc((p->varCount + 1) * sizeof(unsigned long));
+    unsigned long *values = SafeMalloc((p->varCount + 1) * sizeof(unsigned long));
+    for (size_t var = 0; var < p->varCount; var++) {
+        values[var] = var < varCount ? CoeffFromLong(xs[var]) : 0;
+    }
+    prefix[0] = CoeffFromLong(1);
+
+    unsigned long sum = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        size_t var = 0;
+        if (i > 0) {
+            while (var < p->varCount && FieldValue(p->monos[i].exp, p->varCount, var) ==
+                                            FieldValue(p->monos[i - 1].exp, p->varCount, var)) {
+                var++;
+            }
+        }
+        for (; var < p->varCount; var++) {
+            poly_exp_t exp = FieldValue(p->monos[i].exp, p->varCount, var);
+            prefix[var + 1] = CoeffMul(prefix[var], CoeffPow(values[var], (unsigned long)exp));
+        }
+        sum = CoeffAdd(sum, CoeffMul(prefix[p->varCount], (unsigned long)p->monos[i].coeff));
+    }
+    free(values);
+    free(prefix);
+
+    return (poly_coeff_t)sum;
+}
+
+void PackedPolyDestroy(PackedPoly *p) {
+    free(p->monos);
+    p->monos = NULL;
+    p->size = 0;
+}
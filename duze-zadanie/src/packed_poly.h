@@ -0,0 +1,93 @@
+/** @file
+ * Interfejs wielomianów w postaci spakowanej.
+ *
+ * Wielomian spakowany to płaska tablica jednomianów: współczynnik i wektor wykładników
+ * wszystkich zmiennych spakowany do jednej liczby typu uint64_t. Wielomian o @f$k@f$ zmiennych
+ * przeznacza na wykładnik każdej zmiennej pole szerokości @f$\min(\lfloor 64 / k \rfloor, 32)@f$
+ * bitów, z czego najstarszy bit pola jest zawsze zerem (bitem strażniczym). Dzięki temu wektory
+ * wykładników mnoży się jednym dodawaniem, a przepełnienie któregoś pola widać po bitach
+ * strażniczych. Zmienna @f$x_0@f$ zajmuje najstarsze pole, więc jednomiany posortowane rosnąco
+ * po spakowanych wykładnikach są w tej samej kolejności co w drzewie wielomianu.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#ifndef POLYNOMIALS_PACKED_POLY_H
+#define POLYNOMIALS_PACKED_POLY_H
+
+#include "poly.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Jednomian w postaci spakowanej.
+ */
+typedef struct {
+    uint64_t exp;       ///< spakowany wektor wykładników
+    poly_coeff_t coeff; ///< niezerowy współczynnik
+} PackedMono;
+
+/**
+ * Wielomian w postaci spakowanej.
+ */
+typedef struct {
+    size_t varCount;   ///< liczba zmiennych, od której zależy szerokość pól wykładników
+    size_t size;       ///< liczba jednomianów
+    PackedMono *monos; ///< jednomiany posortowane rosnąco po spakowanych wykładnikach
+} PackedPoly;
+
+/**
+ * Zamienia wielomian na postać spakowaną.
+ * @param p : wielomian,
+ * @param varCount : liczba zmiennych postaci spakowanej, od 1 do 64,
+ * @param result : wskaźnik na zapisanie wielomianu spakowanego,
+ * @return false, jeśli wielomian zależy od więcej niż @p varCount zmiennych albo któryś
+ * wykładnik nie mieści się w polu; wtedy nic nie jest zapisywane.
+ */
+bool PackedPolyFromPoly(const Poly *p, size_t varCount, PackedPoly *result);
+
+/**
+ * Zamienia wielomian spakowany na wielomian.
+ * @param p : wielomian spakowany,
+ * @return wielomian równy @p p.
+ */
+Poly PackedPolyToPoly(const PackedPoly *p);
+
+/**
+ * Dodaje dwa wielomiany spakowane o tej samej liczbie zmiennych.
+ * @param p : wielomian spakowany @f$p@f$,
+ * @param q : wielomian spakowany @f$q@f$,
+ * @return @f$p + q@f$.
+ */
+PackedPoly PackedPolyAdd(const PackedPoly *p, const PackedPoly *q);
+
+/**
+ * Mnoży dwa wielomiany spakowane o tej samej liczbie zmiennych.
+ * @param p : wielomian spakowany @f$p@f$,
+ * @param q : wielomian spakowany @f$q@f$,
+ * @param result : wskaźnik na zapisanie @f$p \cdot q@f$,
+ * @return false, jeśli któryś wykładnik iloczynu nie mieści się w polu; wtedy nic nie jest
+ * zapisywane.
+ */
+bool PackedPolyMul(const PackedPoly *p, const PackedPoly *q, PackedPoly *result);
+
+/**
+ * Wylicza wartość wielomianu spakowanego (patrz PolyEval). Zmienne o indeksach nie mniejszych
+ * niż @p varCount przyjmują wartość 0.
+ * @param p : wielomian spakowany,
+ * @param xs : wartości zmiennych,
+ * @param varCount : liczba wartości w tablicy @p xs,
+ * @return wartość wielomianu.
+ */
+poly_coeff_t PackedPolyEval(const PackedPoly *p, const poly_coeff_t *xs, size_t varCount);
+
+/**
+ * Usuwa wielomian spakowany z pamięci.
+ * @param p : wielomian spakowany.
+ */
+void PackedPolyDestroy(PackedPoly *p);
+
+#endif // POLYNOMIALS_PACKED_POLY_H
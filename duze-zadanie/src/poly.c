@@ -8,26 +8,91 @@
  */
 
 #include "poly.h"
+#include "arena.h"
+#include "coeff_ring.h"
+#include "intern_table.h"
 #include "safe_memory_allocation.h"
+#include "thread_pool.h"
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+/**
+ * Dodaje dwa współczynniki w aktualnym pierścieniu współczynników.
+ * @param a : współczynnik @f$a@f$,
+ * @param b : współczynnik @f$b@f$,
+ * @return @f$a + b@f$.
+ */
+static inline poly_coeff_t AddCoeffs(poly_coeff_t a, poly_coeff_t b) {
+    return (poly_coeff_t)CoeffAdd((unsigned long)a, (unsigned long)b);
+}
+
+/**
+ * Mnoży dwa współczynniki w aktualnym pierścieniu współczynników.
+ * @param a : współczynnik @f$a@f$,
+ * @param b : współczynnik @f$b@f$,
+ * @return @f$a \cdot b@f$.
+ */
+static inline poly_coeff_t MulCoeffs(poly_coeff_t a, poly_coeff_t b) {
+    return (poly_coeff_t)CoeffMul((unsigned long)a, (unsigned long)b);
+}
+
+/**
+ * Zwraca współczynnik przeciwny w aktualnym pierścieniu współczynników.
+ * @param a : współczynnik @f$a@f$,
+ * @return @f$-a@f$.
+ */
+static inline poly_coeff_t NegCoeff(poly_coeff_t a) {
+    return (poly_coeff_t)CoeffNeg((unsigned long)a);
+}
+
+/**
+ * Sprawdza, czy wielomian jest korzeniem regionu (patrz PolyMoveToRegion).
+ * @param p : wielomian,
+ * @return Czy usunięcie @p p zwalnia cały region?
+ */
+static inline bool PolyIsRegionRoot(const Poly *p) {
+    return !PolyIsCoeff(p) && MonoArrayIsRegionRoot(p->arr);
+}
+
+/**
+ * Sprawdza, czy wielomian jest współdzielonym węzłem (patrz PolyIntern).
+ * @param p : wielomian,
+ * @return Czy tablica jednomianów @p p jest współdzielona?
+ */
+static inline bool PolyIsInterned(const Poly *p) {
+    return !PolyIsCoeff(p) && MonoArrayIsInterned(p->arr);
+}
 
 void PolyDestroy(Poly *p) {
     if (PolyIsCoeff(p)) {
         return;
     }
+    if (MonoArrayIsInterned(p->arr)) {
+        if (!MonoArrayRelease(p->arr)) {
+            return;
+        }
+        InternTableRemove(p->size, p->arr);
+    }
 
-    for (size_t i = 0; i < p->size; i++) {
-        MonoDestroy(&p->arr[i]);
+    if (!MonoArrayIsRegionRoot(p->arr)) { // Region jest zwalniany w całości.
+        for (size_t i = 0; i < p->size; i++) {
+            MonoDestroy(&p->arr[i]);
+        }
     }
-    free(p->arr);
+    MonoArrayFree(p->arr);
 }
 
 Poly PolyClone(const Poly *p) {
     if (PolyIsCoeff(p)) {
         return (Poly){.arr = NULL, .coeff = p->coeff};
     }
+    if (MonoArrayIsInterned(p->arr)) {
+        MonoArrayRetain(p->arr);
+        return *p;
+    }
 
-    Poly polyCopy = {.size = p->size, .arr = SafeMalloc(p->size * sizeof(Mono))};
+    Poly polyCopy = {.size = p->size, .arr = SafeMonoArrayAlloc(p->size)};
 
     for (size_t i = 0; i < p->size; i++) {
         polyCopy.arr[i] = MonoClone(&p->arr[i]);
@@ -36,6 +101,25 @@ Poly PolyClone(const Poly *p) {
     return polyCopy;
 }
 
+/**
+ * Zapewnia, że tablicę jednomianów wielomianu można modyfikować i przejmować: tablicę
+ * współdzielonego węzła zastępuje płytką kopią. Współczynniki kopii są współdzielonymi węzłami,
+ * więc ich kopiowanie kosztuje tylko zwiększenie liczników odwołań.
+ * @param p : wielomian.
+ */
+static void Unshare(Poly *p) {
+    if (!PolyIsInterned(p)) {
+        return;
+    }
+
+    Poly copy = {.size = p->size, .arr = SafeMonoArrayAlloc(p->size)};
+    for (size_t i = 0; i < p->size; i++) {
+        copy.arr[i] = MonoClone(&p->arr[i]);
+    }
+    PolyDestroy(p);
+    *p = copy;
+}
+
 /**
  * Sprawdza równość dwóch jednomianów.
  * @param m : jednomian @f$m@f$,
@@ -50,11 +134,35 @@ static inline bool MonoIsEq(const Mono *m, const Mono *n) {
     return PolyIsEq(&m->p, &n->p);
 }
 
+size_t PolyHash(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return (size_t)HashMix((uint64_t)p->coeff);
+    }
+
+    size_t hash = MonoArrayCachedHash(p->arr);
+    if (hash == 0) {
+        uint64_t h = HashMix(p->size);
+        for (size_t i = 0; i < p->size; i++) {
+            h = HashMix(h ^ (uint64_t)(uint32_t)p->arr[i].exp);
+            h = HashMix(h ^ PolyHash(&p->arr[i].p));
+        }
+        hash = h != 0 ? (size_t)h : 1; // Zero oznacza brak zapamiętanego skrótu.
+        MonoArraySetCachedHash(p->arr, hash);
+    }
+    return hash;
+}
+
 bool PolyIsEq(const Poly *p, const Poly *q) {
     if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
         return (p->coeff == q->coeff);
     }
+    if (PolyIsInterned(p) && PolyIsInterned(q)) { // Równe węzły współdzielone są tą samą tablicą.
+        return p->arr == q->arr;
+    }
     if (!PolyIsCoeff(p) && !PolyIsCoeff(q) && p->size == q->size) {
+        if (PolyHash(p) != PolyHash(q)) { // Skróty są zapamiętywane, więc zwykle to czas stały.
+            return false;
+        }
         for (size_t i = 0; i < p->size; i++) {
             if (!MonoIsEq(&p->arr[i], &q->arr[i])) {
                 return false;
@@ -137,6 +245,134 @@ bool RecursivePolyIsCoeff(const Poly *p, poly_coeff_t *result) {
     return RecursivePolyIsCoeff(&p->arr[0].p, result);
 }
 
+/**
+ * Zwraca liczbę niezerowych współczynników liczbowych w drzewie wielomianu.
+ * @param p : wielomian,
+ * @return liczba składników wielomianu @p p.
+ */
+static size_t PolyTermCount(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return PolyIsZero(p) ? 0 : 1;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        count += PolyTermCount(&p->arr[i].p);
+    }
+    return count;
+}
+
+/**
+ * Liczy niezerowe współczynniki liczbowe w drzewie wielomianu, ale przerywa, gdy ich
+ * liczba osiągnie @p limit. Progi podziału pracy między wątki sprawdzamy na każdym poziomie
+ * rekurencji, więc nie mogą one za każdym razem przechodzić całych drzew.
+ * @param p : wielomian,
+ * @param limit : dodatnia liczba składników, po której liczenie jest przerywane,
+ * @return liczba składników wielomianu @p p, jeśli jest mniejsza od @p limit,
+ * a w przeciwnym razie liczba nie mniejsza od @p limit.
+ */
+static size_t PolyTermCountUpTo(const Poly *p, size_t limit) {
+    if (PolyIsCoeff(p)) {
+        return PolyIsZero(p) ? 0 : 1;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < p->size && count < limit; i++) {
+        count += PolyTermCountUpTo(&p->arr[i].p, limit - count);
+    }
+    return count;
+}
+
+/**
+ * Najmniejszy rozmiar podproblemu, który jest wydzielany jako osobne zadanie puli wątków:
+ * liczba składników dodawanych wielomianów albo liczba iloczynów składników mnożonych
+ * wielomianów. Mniejsze podproblemy są liczone sekwencyjnie, bo koszt zgłoszenia zadania
+ * przewyższyłby zysk.
+ */
+#define PARALLEL_TASK_MIN_TERMS (1 << 12)
+
+/**
+ * Czy bieżący wątek buduje wynik bezpośrednio w arenie regionu (patrz AddIntoRegion)?
+ * Wszystkie tablice regionu muszą pochodzić z jego areny, a zadania puli wątków przydzielają
+ * tablice poza nią, więc obliczenia nie są wtedy dzielone między wątki.
+ */
+static _Thread_local bool buildingRegion = false;
+
+/**
+ * Sprawdza, czy obliczenia mogą być dzielone między wątki.
+ * @return Czy ustawiono więcej niż jeden wątek i bieżący wątek nie buduje regionu?
+ */
+static inline bool IsParallel(void) {
+    return !buildingRegion && ThreadPoolThreadCount() > 1;
+}
+
+/**
+ * Zadanie wyliczające sumę albo iloczyn dwóch poddrzew wielomianów.
+ */
+typedef struct {
+    const Poly *p; ///< pierwszy argument
+    const Poly *q; ///< drugi argument
+    size_t index;  ///< pozycja wyniku w tablicy jednomianów wywołującego
+    Poly result;   ///< wynik działania
+} PolyOpTask;
+
+/**
+ * Wykonuje zadanie dodawania.
+ * @param arg : wskaźnik na PolyOpTask.
+ */
+static void RunAddTask(void *arg) {
+    PolyOpTask *task = arg;
+    task->result = PolyAdd(task->p, task->q);
+}
+
+/**
+ * Wykonuje zadanie mnożenia.
+ * @param arg : wskaźnik na PolyOpTask.
+ */
+static void RunMulTask(void *arg) {
+    PolyOpTask *task = arg;
+    task->result = PolyMul(task->p, task->q);
+}
+
+/**
+ * Usuwa z tablicy jednomiany zerowe, zachowując kolejność pozostałych.
+ * @param count : liczba jednomianów,
+ * @param monos : tablica jednomianów,
+ * @return liczba jednomianów niezerowych.
+ */
+static size_t RemoveZeroMonos(size_t count, Mono *monos) {
+    size_t newCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!MonoIsZero(&monos[i])) {
+            monos[newCount++] = monos[i];
+        }
+    }
+    return newCount;
+}
+
+/**
+ * Czeka na zakończenie zadań i wstawia ich wyniki jako współczynniki jednomianów na
+ * zapisanych w zadaniach pozycjach, a następnie usuwa z tablicy jednomiany zerowe.
+ * @param group : grupa zadań,
+ * @param tasks : tablica zadań,
+ * @param taskCount : liczba zadań,
+ * @param monos : tablica jednomianów,
+ * @param count : liczba jednomianów,
+ * @return liczba jednomianów po usunięciu zerowych.
+ */
+static size_t CollectTaskResults(TaskGroup *group, PolyOpTask *tasks, size_t taskCount,
+                                 Mono *monos, size_t count) {
+    if (taskCount == 0) {
+        return count;
+    }
+
+    ThreadPoolWait(group);
+    for (size_t i = 0; i < taskCount; i++) {
+        monos[tasks[i].index].p = tasks[i].result;
+    }
+    return RemoveZeroMonos(count, monos);
+}
+
 /**
  * Sumuje dwa jednomiany o tym samym wykładniku.
  * @param m : jednomian @f$m@f$,
@@ -149,127 +385,247 @@ static inline Mono AddMonos(const Mono *m, const Mono *n) {
     return (Mono){.exp = m->exp, .p = PolyAdd(&m->p, &n->p)};
 }
 
+#ifndef NDEBUG
 /**
- * Dodaje jednomiany z tablicy monos do siebie, tworząc nowy wielomian.
- * @param count : liczba jednomianów do dodania,
- * @param *monos : wskaźnik na tablicę jednomianów do dodania,
- * @return Poly : wielomian będący wynikiem dodawania jednomianów.
+ * Płytko sprawdza niezmiennik postaci kanonicznej dla tablicy jednomianów
+ * budowanego węzła: wykładniki rosną ściśle, a współczynniki są niezerowe.
+ * Współczynniki powstały wcześniej, więc już spełniają niezmiennik i nie
+ * trzeba ich przechodzić w głąb.
+ * @param count : liczba jednomianów,
+ * @param monos : tablica jednomianów,
+ * @return Czy tablica spełnia niezmiennik?
+ */
+static bool MonosAreCanonical(size_t count, const Mono *monos) {
+    for (size_t i = 0; i < count; i++) {
+        if (PolyIsZero(&monos[i].p) || (i > 0 && monos[i].exp <= monos[i - 1].exp)) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+/**
+ * Tworzy wielomian z tablicy niezerowych jednomianów posortowanych ściśle
+ * rosnąco po wykładnikach. Przejmuje na własność tablicę @p monos.
+ * Pusta tablica daje wielomian zerowy, a pojedynczy jednomian o wykładniku 0,
+ * którego współczynnik jest stały, jest zamieniany na ten współczynnik.
+ * @param count : liczba jednomianów w tablicy,
+ * @param capacity : liczba jednomianów, na którą zaalokowano tablicę,
+ * @param monos : tablica jednomianów,
+ * @return wielomian złożony z jednomianów @p monos.
+ */
+static Poly PolyFromSortedMonos(size_t count, size_t capacity, Mono *monos) {
+    assert(MonosAreCanonical(count, monos));
+    if (count == 0) {
+        MonoArrayFree(monos);
+        return PolyZero();
+    }
+    if (count == 1 && MonoGetExp(&monos[0]) == 0 && PolyIsCoeff(&monos[0].p)) {
+        poly_coeff_t coeff = monos[0].p.coeff;
+        MonoArrayFree(monos);
+        return PolyFromCoeff(coeff);
+    }
+    if (count < capacity) {
+        monos = SafeMonoArrayRealloc(monos, count);
+    }
+    MonoArrayInvalidate(monos); // Tablica mogła zostać przejęta od argumentu i zmieniona.
+
+    return (Poly){.size = count, .arr = monos};
+}
+
+/**
+ * Sumuje grupę jednomianów o tym samym wykładniku w miejscu: współczynniki
+ * kolejnych jednomianów są przenoszone do sumy, a suma trafia na miejsce
+ * pierwszego jednomianu grupy. Sumy wielomianów w postaci kanonicznej są
+ * w postaci kanonicznej, więc zerowość sumy wystarczy sprawdzić płytko.
+ * @param count : liczba jednomianów w grupie, dodatnia,
+ * @param monos : tablica jednomianów; współczynniki jednomianów poza
+ * pierwszym stają się zerowe.
  */
-static inline Poly AddMonosArray(size_t count, const Mono *monos) {
-    size_t polyI = 0, monosI = 0;
-    Poly newPoly = {.size = count, .arr = SafeMalloc(count * sizeof(Mono))};
+static void SumMonoGroupInPlace(size_t count, Mono *monos) {
+    for (size_t i = 1; i < count; i++) {
+        monos[0].p = PolyAddMove(&monos[0].p, &monos[i].p);
+    }
+}
 
-    while (monosI < count) {
-        newPoly.arr[polyI] = MonoClone(&monos[monosI++]);
+/**
+ * Zadanie sumujące grupę jednomianów o tym samym wykładniku.
+ */
+typedef struct {
+    size_t count; ///< liczba jednomianów w grupie
+    Mono *monos;  ///< początek grupy, na którym zostanie zapisana suma
+} MonoGroupTask;
 
-        while (monosI < count && monos[monosI].exp == monos[monosI - 1].exp) {
-            Mono temp = newPoly.arr[polyI];
-            newPoly.arr[polyI] = AddMonos(&temp, &monos[monosI++]);
-            MonoDestroy(&temp);
+/**
+ * Wykonuje zadanie sumowania grupy jednomianów.
+ * @param arg : wskaźnik na MonoGroupTask.
+ */
+static void RunMonoGroupTask(void *arg) {
+    MonoGroupTask *task = arg;
+    SumMonoGroupInPlace(task->count, task->monos);
+}
 
-            if (RecursiveMonoIsZero(&newPoly.arr[polyI])) {
-                poly_exp_t tempExp = newPoly.arr[polyI].exp;
-                MonoDestroy(&newPoly.arr[polyI]);
-                newPoly.arr[polyI] = (Mono){.exp = tempExp, .p = PolyZero()};
-            }
+/**
+ * Dodaje do siebie jednomiany z tablicy, przejmując ją na własność i budując
+ * wynik w miejscu. Najpierw suma każdej grupy jednomianów o równym wykładniku
+ * trafia na miejsce pierwszego jednomianu grupy, a potem niezerowe sumy są
+ * przesuwane na początek tablicy. Jednomiany są tylko przenoszone, więc żadne
+ * poddrzewo nie jest kopiowane. Duże grupy są sumowane jako zadania puli
+ * wątków; każde zadanie pisze tylko w obrębie własnej grupy.
+ * @param count : liczba jednomianów do dodania,
+ * @param monos : tablica przydzielona przez SafeMonoArrayAlloc, posortowana po wykładnikach,
+ * @return wielomian będący sumą jednomianów.
+ */
+static Poly AddMonosArrayMove(size_t count, Mono *monos) {
+    TaskGroup group = {.pending = 0};
+    MonoGroupTask *tasks = IsParallel() ? SafeMalloc(count * sizeof(MonoGroupTask)) : NULL;
+    size_t taskCount = 0;
+
+    for (size_t groupBegin = 0, groupEnd; groupBegin < count; groupBegin = groupEnd) {
+        size_t groupTerms = 0;
+        for (groupEnd = groupBegin + 1;
+             groupEnd < count && monos[groupEnd].exp == monos[groupBegin].exp; groupEnd++) {
+        }
+        for (size_t i = groupBegin;
+             tasks != NULL && i < groupEnd && groupTerms < PARALLEL_TASK_MIN_TERMS; i++) {
+            groupTerms += PolyTermCountUpTo(&monos[i].p, PARALLEL_TASK_MIN_TERMS - groupTerms);
         }
 
-        if (!MonoIsZero(&newPoly.arr[polyI])) {
-            polyI++;
+        if (groupTerms >= PARALLEL_TASK_MIN_TERMS) {
+            tasks[taskCount] = (MonoGroupTask){.count = groupEnd - groupBegin,
+                                               .monos = monos + groupBegin};
+            ThreadPoolSpawn(&group, RunMonoGroupTask, &tasks[taskCount++]);
+        } else {
+            SumMonoGroupInPlace(groupEnd - groupBegin, monos + groupBegin);
         }
     }
+    if (taskCount > 0) {
+        ThreadPoolWait(&group);
+    }
+    free(tasks);
 
-    newPoly.size = polyI;
-    if (newPoly.size == 0) {
-        PolyDestroy(&newPoly);
-        return PolyZero();
+    // Sumy leżą na początkach grup, czyli tam, gdzie zmienia się wykładnik.
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        bool groupBegin = i == 0 || monos[i].exp != monos[i - 1].exp;
+        if (groupBegin && !MonoIsZero(&monos[i])) {
+            monos[kept++] = monos[i];
+        }
     }
 
-    return newPoly;
+    return PolyFromSortedMonos(kept, count, monos);
 }
 
 Poly PolyAddMonos(size_t count, const Mono monos[]) {
-    Mono *newMonos = SafeMalloc(count * sizeof(Mono));
-    for (size_t i = 0; i < count; i++) {
-        newMonos[i] = monos[i];
+    if (count == 0) {
+        return PolyZero();
     }
 
+    Mono *newMonos = SafeMonoArrayAlloc(count);
+    memcpy(newMonos, monos, count * sizeof(Mono));
     SortMonosByExp(count, newMonos);
-    Poly newPoly = AddMonosArray(count, newMonos);
-
-    poly_coeff_t coeff;
-    if (RecursivePolyIsCoeff((&newPoly), &coeff)) {
-        poly_coeff_t tmp = coeff;
-        PolyDestroy(&newPoly);
-        newPoly.coeff = tmp;
-        newPoly.arr = NULL;
-    }
-
-    for (size_t j = 0; j < count; j++) { // Czyszczenie pamięci po tablicy newMonos.
-        MonoDestroy(&newMonos[j]);
-    }
-    free(newMonos);
 
-    return newPoly;
+    return AddMonosArrayMove(count, newMonos);
 }
 
 /**
  * Dodaje dwa wielomiany do siebie: jeden z nich jest współczynnikiem, drugi
  * wielomianem o niezerowym wykładniku.
+ * Współczynnik traktujemy jak jednomian o wykładniku 0, więc wystarczy go
+ * dodać do pierwszego jednomianu @p q (jeśli ma wykładnik 0) albo dopisać na
+ * początek, a pozostałe jednomiany skopiować.
  * @param p : wielomian @f$p@f$ stały - współczynnik,
  * @param q : wielomian @f$q@f$ o niezerowym wykładniku,
  * @return @f$p + q@f$ .
  */
 static inline Poly AddCoeffToPoly(const Poly *p, const Poly *q) {
-    assert(PolyIsCoeff(p));
+    assert(PolyIsCoeff(p) && !PolyIsCoeff(q));
 
     if (PolyIsZero(p)) {
         return PolyClone(q);
     }
 
-    size_t size = q->size + 1;
-    Mono *monos = SafeMalloc(size * sizeof(Mono));
-    monos[0] = MonoFromPoly(p, 0);
+    Mono *monos = SafeMonoArrayAlloc(q->size + 1);
+    size_t count = 0, qI = 0;
 
-    for (size_t i = 1; i < size; i++) {
-        monos[i] = MonoClone(&q->arr[i - 1]);
+    if (MonoGetExp(&q->arr[0]) == 0) {
+        Poly sum = PolyAdd(p, &q->arr[qI++].p);
+        if (!PolyIsZero(&sum)) {
+            monos[count++] = MonoFromPoly(&sum, 0);
+        }
+    } else {
+        monos[count++] = MonoFromPoly(p, 0);
     }
 
-    Poly newPoly = PolyAddMonos(size, monos);
-
-    free(monos);
+    while (qI < q->size) {
+        monos[count++] = MonoClone(&q->arr[qI++]);
+    }
 
-    return newPoly;
+    return PolyFromSortedMonos(count, q->size + 1, monos);
 }
 
 /**
  * Dodaje dwa wielomiany do siebie: obydwa z nich nie są wielomianami stałymi.
+ * Obie listy jednomianów są posortowane po wykładnikach, więc scalamy je
+ * liniowo, a rekurencyjnie dodajemy tylko współczynniki przy równych
+ * wykładnikach.
  * @param p : wielomian @f$p@f$ o niezerowym wykładniku,
  * @param q : wielomian @f$q@f$ o niezerowym wykładniku,
  * @return @f$p + q@f$.
  */
 static inline Poly AddNonCoeffPolys(const Poly *p, const Poly *q) {
-    size_t size = p->size + q->size;
+    assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
 
-    Mono *monos = SafeMalloc(size * sizeof(Mono));
+    size_t capacity = p->size + q->size;
+    Mono *monos = SafeMonoArrayAlloc(capacity);
+    size_t count = 0, pI = 0, qI = 0;
 
-    for (size_t i = 0; i < p->size; i++) {
-        monos[i] = MonoClone(&p->arr[i]);
-    }
-    for (size_t i = 0; i < q->size; i++) {
-        monos[p->size + i] = MonoClone(&q->arr[i]);
+    TaskGroup group = {.pending = 0};
+    PolyOpTask *tasks = NULL;
+    size_t taskCount = 0;
+    if (IsParallel()) {
+        tasks = SafeMalloc((p->size < q->size ? p->size : q->size) * sizeof(PolyOpTask));
     }
 
-    Poly newPoly = PolyAddMonos(size, monos);
+    while (pI < p->size && qI < q->size) {
+        poly_exp_t pExp = MonoGetExp(&p->arr[pI]), qExp = MonoGetExp(&q->arr[qI]);
+
+        if (pExp < qExp) {
+            monos[count++] = MonoClone(&p->arr[pI++]);
+        } else if (pExp > qExp) {
+            monos[count++] = MonoClone(&q->arr[qI++]);
+        } else if (tasks != NULL &&
+                   PolyTermCountUpTo(&p->arr[pI].p, PARALLEL_TASK_MIN_TERMS) +
+                   PolyTermCountUpTo(&q->arr[qI].p, PARALLEL_TASK_MIN_TERMS) >=
+                   PARALLEL_TASK_MIN_TERMS) {
+            tasks[taskCount] = (PolyOpTask){.p = &p->arr[pI++].p, .q = &q->arr[qI++].p,
+                                            .index = count};
+            monos[count++] = (Mono){.exp = pExp, .p = PolyZero()};
+            ThreadPoolSpawn(&group, RunAddTask, &tasks[taskCount++]);
+        } else {
+            Mono sum = AddMonos(&p->arr[pI++], &q->arr[qI++]);
+            if (!MonoIsZero(&sum)) {
+                monos[count++] = sum;
+            }
+        }
+    }
+    while (pI < p->size) {
+        monos[count++] = MonoClone(&p->arr[pI++]);
+    }
+    while (qI < q->size) {
+        monos[count++] = MonoClone(&q->arr[qI++]);
+    }
 
-    free(monos);
+    count = CollectTaskResults(&group, tasks, taskCount, monos, count);
+    free(tasks);
 
-    return newPoly;
+    return PolyFromSortedMonos(count, capacity, monos);
 }
 
 Poly PolyAdd(const Poly *p, const Poly *q) {
     if (PolyIsCoeff(p) && PolyIsCoeff(q)) { // Obydwa są wielomianami stałymi.
-        return PolyFromCoeff(p->coeff + q->coeff);
+        return PolyFromCoeff(AddCoeffs(p->coeff, q->coeff));
     } else if (!PolyIsCoeff(p) && !PolyIsCoeff(q)) { // Obydwa są wielomianami niestałymi.
         return AddNonCoeffPolys(p, q);
     } else { // Jeden jest wielomianem stałym, a drugi niestałym.
@@ -281,6 +637,178 @@ Poly PolyAdd(const Poly *p, const Poly *q) {
     }
 }
 
+/**
+ * Dodaje współczynnik do wielomianu niestałego, przejmując na własność
+ * zawartość @p q i wykorzystując jego tablicę jednomianów.
+ * @param c : współczynnik,
+ * @param q : wielomian niebędący współczynnikiem,
+ * @return @f$c + q@f$.
+ */
+static Poly AddCoeffToPolyMove(poly_coeff_t c, Poly *q) {
+    assert(!PolyIsCoeff(q));
+
+    Poly result = *q;
+    *q = PolyZero();
+
+    if (c == 0) {
+        return result;
+    }
+
+    Poly coeff = PolyFromCoeff(c);
+    if (MonoGetExp(&result.arr[0]) == 0) {
+        result.arr[0].p = PolyAddMove(&coeff, &result.arr[0].p);
+        if (!PolyIsZero(&result.arr[0].p)) {
+            return PolyFromSortedMonos(result.size, result.size, result.arr);
+        }
+        memmove(result.arr, result.arr + 1, (result.size - 1) * sizeof(Mono));
+        return PolyFromSortedMonos(result.size - 1, result.size, result.arr);
+    }
+
+    result.arr = SafeMonoArrayRealloc(result.arr, result.size + 1);
+    memmove(result.arr + 1, result.arr, result.size * sizeof(Mono));
+    result.arr[0] = MonoFromPoly(&coeff, 0);
+    result.size++;
+
+    return result;
+}
+
+/**
+ * Dodaje dwa wielomiany niestałe, przejmując na własność ich zawartość.
+ * Tablica jednomianów @p p jest powiększana i scalana od końca, więc
+ * nieprzeczytane jednomiany @p p nigdy nie są nadpisywane. Z tablicy @p q
+ * przenosimy jednomiany i zwalniamy tylko ją samą.
+ * @param p : wielomian niebędący współczynnikiem,
+ * @param q : wielomian niebędący współczynnikiem,
+ * @return @f$p + q@f$.
+ */
+static Poly AddNonCoeffPolysMove(Poly *p, Poly *q) {
+    assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
+
+    size_t capacity = p->size + q->size;
+    Mono *monos = SafeMonoArrayRealloc(p->arr, capacity);
+    size_t pI = p->size, qI = q->size, k = capacity;
+
+    while (pI > 0 && qI > 0) {
+        poly_exp_t pExp = MonoGetExp(&monos[pI - 1]), qExp = MonoGetExp(&q->arr[qI - 1]);
+
+        if (pExp > qExp) {
+            monos[--k] = monos[--pI];
+        } else if (pExp < qExp) {
+            monos[--k] = q->arr[--qI];
+        } else {
+            pI--;
+            qI--;
+            Poly sum = PolyAddMove(&monos[pI].p, &q->arr[qI].p);
+            if (!PolyIsZero(&sum)) {
+                monos[--k] = MonoFromPoly(&sum, pExp);
+            }
+        }
+    }
+    while (qI > 0) {
+        monos[--k] = q->arr[--qI];
+    }
+    while (pI > 0) {
+        monos[--k] = monos[--pI];
+    }
+
+    size_t count = capacity - k;
+    memmove(monos, monos + k, count * sizeof(Mono));
+    MonoArrayFree(q->arr);
+    *p = PolyZero();
+    *q = PolyZero();
+
+    return PolyFromSortedMonos(count, capacity, monos);
+}
+
+/**
+ * Krotność, o którą arena regionu może przerosnąć jego drzewo, zanim region zostanie
+ * przepisany do nowej, dokładnie dopasowanej areny.
+ */
+#define REGION_MAX_SIZE_RATIO 4
+
+static size_t RegionSize(const Poly *p);
+static Poly CopyTree(const Poly *p);
+static Poly CopyToRegion(const Poly *p);
+
+/**
+ * Dodaje dwa wielomiany, z których co najmniej jeden jest korzeniem regionu, przejmując region
+ * większego z nich. Jednomiany drugiego składnika są kopiowane do tego regionu, a potem suma
+ * powstaje w miejscu, tak jak poza regionami; nowe tablice są przydzielane w arenie regionu.
+ * Porzucone tablice zajmują arenę aż do zwolnienia regionu, więc gdy arena urośnie ponad
+ * REGION_MAX_SIZE_RATIO rozmiarów drzewa, suma jest przepisywana do nowego regionu.
+ * Przejmuje na własność zawartość @p p i @p q.
+ * @param p : wielomian @f$p@f$,
+ * @param q : wielomian @f$q@f$,
+ * @return @f$p + q@f$.
+ */
+static Poly AddIntoRegion(Poly *p, Poly *q) {
+    if (!PolyIsRegionRoot(p) || (PolyIsRegionRoot(q) && ArenaSize(MonoArrayArena(q->arr)) >
+                                                        ArenaSize(MonoArrayArena(p->arr)))) {
+        Poly *tmp = p;
+        p = q;
+        q = tmp;
+    }
+
+    Arena *region = MonoArrayArena(p->arr);
+    size_t regionSize = ArenaSize(region);
+    Arena *previous = MonoArraySetArena(region);
+    buildingRegion = true;
+    Poly addend = CopyTree(q);
+    PolyDestroy(q);
+    *q = PolyZero();
+    Poly result;
+    if (PolyIsCoeff(&addend)) {
+        result = AddCoeffToPolyMove(addend.coeff, p);
+    } else { // Wynik musi zostać w tablicy korzenia regionu, więc nie zamieniamy argumentów.
+        result = AddNonCoeffPolysMove(p, &addend);
+    }
+    buildingRegion = false;
+    MonoArraySetArena(previous);
+
+    // Rozmiar drzewa liczymy tylko wtedy, gdy arena urosła, czyli rzadko.
+    if (!PolyIsCoeff(&result) && ArenaSize(region) > regionSize &&
+        ArenaSize(region) > REGION_MAX_SIZE_RATIO * RegionSize(&result)) {
+        Poly copy = CopyToRegion(&result);
+        PolyDestroy(&result);
+        result = copy;
+    }
+    return result;
+}
+
+Poly PolyAddMove(Poly *p, Poly *q) {
+    if (PolyIsRegionRoot(p) || PolyIsRegionRoot(q)) {
+        return AddIntoRegion(p, q);
+    }
+    // Jednomianów węzła współdzielonego nie wolno przenosić.
+    if (PolyIsInterned(p) || PolyIsInterned(q)) {
+        Poly result = PolyAdd(p, q);
+        PolyDestroy(p);
+        PolyDestroy(q);
+        *p = PolyZero();
+        *q = PolyZero();
+        return result;
+    }
+    if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
+        Poly result = PolyFromCoeff(AddCoeffs(p->coeff, q->coeff));
+        *p = PolyZero();
+        *q = PolyZero();
+        return result;
+    } else if (!PolyIsCoeff(p) && !PolyIsCoeff(q)) {
+        if (p->size < q->size) { // Powiększamy większą z tablic.
+            return AddNonCoeffPolysMove(q, p);
+        }
+        return AddNonCoeffPolysMove(p, q);
+    } else if (PolyIsCoeff(p)) {
+        poly_coeff_t c = p->coeff;
+        *p = PolyZero();
+        return AddCoeffToPolyMove(c, q);
+    } else {
+        poly_coeff_t c = q->coeff;
+        *q = PolyZero();
+        return AddCoeffToPolyMove(c, p);
+    }
+}
+
 /**
  * Zwraca przeciwny jednomian.
  * @param m : jednomian @f$m@f$,
@@ -292,10 +820,10 @@ static inline Mono MonoNeg(const Mono *m) {
 
 Poly PolyNeg(const Poly *p) {
     if (PolyIsCoeff(p)) {
-        return (Poly){.arr = NULL, .coeff = -p->coeff};
+        return (Poly){.arr = NULL, .coeff = NegCoeff(p->coeff)};
     }
 
-    Poly polyCopy = {.size = p->size, .arr = SafeMalloc(p->size * sizeof(Mono))};
+    Poly polyCopy = {.size = p->size, .arr = SafeMonoArrayAlloc(p->size)};
 
     for (size_t i = 0; i < p->size; i++) {
         polyCopy.arr[i] = MonoNeg(&p->arr[i]);
@@ -304,6 +832,31 @@ Poly PolyNeg(const Poly *p) {
     return polyCopy;
 }
 
+/**
+ * Zamienia wielomian na przeciwny w miejscu.
+ * @param p : wielomian @f$p@f$.
+ */
+static void NegateInPlace(Poly *p) {
+    if (PolyIsCoeff(p)) {
+        p->coeff = NegCoeff(p->coeff);
+        return;
+    }
+
+    Unshare(p);
+    MonoArrayInvalidate(p->arr);
+    for (size_t i = 0; i < p->size; i++) {
+        NegateInPlace(&p->arr[i].p);
+    }
+}
+
+Poly PolyNegMove(Poly *p) {
+    Poly result = *p;
+    *p = PolyZero();
+    NegateInPlace(&result);
+
+    return result;
+}
+
 Poly PolySub(const Poly *p, const Poly *q) {
     Poly minusQ = PolyNeg(q);
     Poly resultPoly = PolyAdd(p, &minusQ);
@@ -312,17 +865,83 @@ Poly PolySub(const Poly *p, const Poly *q) {
     return resultPoly;
 }
 
+Poly PolySubMove(Poly *p, Poly *q) {
+    Poly minusQ = PolyNegMove(q);
+
+    return PolyAddMove(p, &minusQ);
+}
+
 /**
- * Zwraca głęboki stopień jednomianu.
- * @param m : jednomian,
- * @return stopień jednomianu @p m.
+ * Liczy stopnie wielomianu niestałego, korzystając ze stopni zapamiętanych
+ * we współczynnikach.
+ * @param p : wielomian niebędący współczynnikiem,
+ * @return stopnie @p p przydzielone funkcją malloc.
  */
-static inline poly_exp_t MonoDeg(const Mono *m) {
-    if (PolyIsCoeff(&m->p)) {
-        return MonoGetExp(m);
+static PolyDegrees *ComputeDegrees(const Poly *p);
+
+/**
+ * Zwraca stopnie wielomianu niestałego zapamiętane w jego węźle, w razie
+ * potrzeby je licząc. Stopnie nie są zapamiętywane w tablicach z areny, bo
+ * pamięci areny nie da się zwolnić razem z tablicą.
+ * @param p : wielomian niebędący współczynnikiem,
+ * @return stopnie @p p albo NULL, jeśli tablica @p p leży w arenie.
+ */
+static const PolyDegrees *CachedDegrees(const Poly *p) {
+    const PolyDegrees *degrees = MonoArrayCachedDegrees(p->arr);
+    if (degrees != NULL || MonoArrayInArena(p->arr)) {
+        return degrees;
+    }
+    return MonoArrayCacheDegrees(p->arr, ComputeDegrees(p));
+}
+
+/**
+ * Powiększa stopnie wielomianu o kolejne zmienne, od których wielomian nie zależy.
+ * @param degrees : stopnie przydzielone funkcją malloc,
+ * @param varCount : nowa liczba zmiennych,
+ * @return powiększone stopnie.
+ */
+static PolyDegrees *GrowDegrees(PolyDegrees *degrees, size_t varCount) {
+    degrees = SafeRealloc(degrees, sizeof(PolyDegrees) + varCount * sizeof(poly_exp_t));
+    for (size_t var = degrees->varCount; var < varCount; var++) {
+        degrees->degBy[var] = 0;
     }
+    degrees->varCount = varCount;
+    return degrees;
+}
+
+static PolyDegrees *ComputeDegrees(const Poly *p) {
+    assert(!PolyIsCoeff(p));
 
-    return MonoGetExp(m) + PolyDeg(&m->p);
+    PolyDegrees *degrees = SafeMalloc(sizeof(PolyDegrees) + sizeof(poly_exp_t));
+    degrees->deg = 0;
+    degrees->varCount = 1;
+    degrees->degBy[0] = MonoGetExp(&p->arr[p->size - 1]);
+
+    for (size_t i = 0; i < p->size; i++) {
+        const Poly *coeff = &p->arr[i].p;
+        poly_exp_t monoDeg = MonoGetExp(&p->arr[i]);
+
+        if (!PolyIsCoeff(coeff)) {
+            const PolyDegrees *cached = CachedDegrees(coeff);
+            PolyDegrees *computed = cached == NULL ? ComputeDegrees(coeff) : NULL;
+            const PolyDegrees *coeffDegrees = cached != NULL ? cached : computed;
+
+            if (coeffDegrees->varCount + 1 > degrees->varCount) {
+                degrees = GrowDegrees(degrees, coeffDegrees->varCount + 1);
+            }
+            for (size_t var = 0; var < coeffDegrees->varCount; var++) {
+                if (coeffDegrees->degBy[var] > degrees->degBy[var + 1]) {
+                    degrees->degBy[var + 1] = coeffDegrees->degBy[var];
+                }
+            }
+            monoDeg += coeffDegrees->deg;
+            free(computed);
+        }
+        if (monoDeg > degrees->deg) {
+            degrees->deg = monoDeg;
+        }
+    }
+    return degrees;
 }
 
 poly_exp_t PolyDeg(const Poly *p) {
@@ -333,24 +952,18 @@ poly_exp_t PolyDeg(const Poly *p) {
         return 0;
     }
 
-    poly_exp_t max = 0;
-    for (size_t i = 0; i < p->size; i++) {
-        poly_exp_t curr = MonoDeg(&p->arr[i]);
-        if (curr > max) {
-            max = curr;
+    if (MonoArrayInArena(p->arr)) { // Tablice z areny nie zapamiętują stopni.
+        poly_exp_t max = 0;
+        for (size_t i = 0; i < p->size; i++) {
+            poly_exp_t curr = MonoGetExp(&p->arr[i]) + PolyDeg(&p->arr[i].p);
+            if (curr > max) {
+                max = curr;
+            }
         }
+        return max;
     }
-    return max;
-}
-
-/**
- * Zwraca stopień jednomianu ze względu na zadaną zmienną.
- * @param m : jednomian @f$m@f$ ,
- * @param varIndex : indeks zmiennej,
- * @return stopień jednomianu @p m z względu na zmienną o indeksie @p varIndex.
- */
-static inline poly_exp_t MonoDegBy(const Mono *m, size_t varIndex) {
-    return PolyDegBy(&m->p, varIndex);
+
+    return CachedDegrees(p)->deg;
 }
 
 poly_exp_t PolyDegBy(const Poly *p, size_t varIndex) {
@@ -364,14 +977,20 @@ poly_exp_t PolyDegBy(const Poly *p, size_t varIndex) {
         return MonoGetExp(&p->arr[p->size - 1]); // Zwracamy największą potęgę.
     }
 
-    poly_exp_t max = 0;
-    for (size_t i = 0; i < p->size; i++) {
-        poly_exp_t curr = MonoDegBy(&p->arr[i], varIndex - 1);
-        if (curr > max) {
-            max = curr;
+    // Tablice z areny nie zapamiętują stopni, więc schodzimy tylko do głębokości zmiennej.
+    if (MonoArrayInArena(p->arr)) {
+        poly_exp_t max = 0;
+        for (size_t i = 0; i < p->size; i++) {
+            poly_exp_t curr = PolyDegBy(&p->arr[i].p, varIndex - 1);
+            if (curr > max) {
+                max = curr;
+            }
         }
+        return max;
     }
-    return max;
+
+    const PolyDegrees *degrees = CachedDegrees(p);
+    return varIndex < degrees->varCount ? degrees->degBy[varIndex] : 0;
 }
 
 /**
@@ -393,118 +1012,1855 @@ static inline Mono MonoMul(const Mono *m, const Mono *n) {
 static inline Poly MultiplyCoeffs(const Poly *p, const Poly *q) {
     assert(PolyIsCoeff(p) && PolyIsCoeff(q));
 
-    return PolyFromCoeff(p->coeff * q->coeff);
+    return PolyFromCoeff(MulCoeffs(p->coeff, q->coeff));
+}
+
+/**
+ * Element kopca używanego przy mnożeniu wielomianów niestałych. Reprezentuje
+ * iloczyn jednomianu @p aIndex krótszego czynnika przez jednomian @p bIndex
+ * dłuższego czynnika.
+ */
+typedef struct {
+    poly_exp_t exp; ///< wykładnik iloczynu
+    size_t aIndex;  ///< indeks jednomianu krótszego czynnika
+    size_t bIndex;  ///< indeks jednomianu dłuższego czynnika
+} MulHeapEntry;
+
+/**
+ * Przywraca własność kopca minimalnego (po wykładnikach), przesuwając element
+ * z pozycji @p i w dół.
+ * @param heap : kopiec,
+ * @param size : rozmiar kopca,
+ * @param i : indeks przesuwanego elementu.
+ */
+static void MulHeapSiftDown(MulHeapEntry *heap, size_t size, size_t i) {
+    MulHeapEntry entry = heap[i];
+
+    while (2 * i + 1 < size) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < size && heap[child + 1].exp < heap[child].exp) {
+            child++;
+        }
+        if (heap[child].exp >= entry.exp) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = entry;
+}
+
+/**
+ * Dopisuje jednomian na koniec tablicy, powiększając ją w razie potrzeby.
+ * @param monos : wskaźnik na tablicę jednomianów,
+ * @param count : wskaźnik na liczbę jednomianów w tablicy,
+ * @param capacity : wskaźnik na liczbę jednomianów, na którą zaalokowano tablicę,
+ * @param m : dopisywany jednomian.
+ */
+static void AppendMono(Mono **monos, size_t *count, size_t *capacity, Mono m) {
+    if (*count == *capacity) {
+        *capacity *= 2;
+        *monos = SafeMonoArrayRealloc(*monos, *capacity);
+    }
+    (*monos)[(*count)++] = m;
+}
+
+/**
+ * Największa liczba par jednomianów najwyższego poziomu, dla której przy mnożeniu na wielu
+ * wątkach iloczyny współczynników wszystkich par są liczone z góry jako osobne zadania.
+ * Przy większej liczbie par dzielony jest jeden z czynników (patrz MultiplyInParallel).
+ */
+#define PARALLEL_MUL_MAX_PAIRS 1024
+
+/**
+ * Liczy iloczyny współczynników wszystkich par jednomianów dwóch wielomianów.
+ * Iloczyny dużych współczynników są liczone jako zadania puli wątków, a w tym
+ * czasie wywołujący wątek liczy iloczyny małych.
+ * @param a : wielomian niebędący współczynnikiem,
+ * @param b : wielomian niebędący współczynnikiem,
+ * @return tablica iloczynów, iloczyn współczynników @f$i@f$-tego jednomianu @p a
+ * i @f$j@f$-tego jednomianu @p b jest pod indeksem @f$i \cdot |b| + j@f$.
+ */
+static Poly *MultiplyCoeffPairs(const Poly *a, const Poly *b) {
+    size_t *bTerms = SafeMalloc(b->size * sizeof(size_t));
+    for (size_t j = 0; j < b->size; j++) {
+        bTerms[j] = PolyTermCountUpTo(&b->arr[j].p, PARALLEL_TASK_MIN_TERMS);
+    }
+
+    Poly *products = SafeMalloc(a->size * b->size * sizeof(Poly));
+    PolyOpTask *tasks = SafeMalloc(a->size * b->size * sizeof(PolyOpTask));
+    size_t taskCount = 0;
+    TaskGroup group = {.pending = 0};
+
+    for (size_t i = 0; i < a->size; i++) {
+        size_t aTerms = PolyTermCountUpTo(&a->arr[i].p, PARALLEL_TASK_MIN_TERMS);
+        for (size_t j = 0; j < b->size; j++) {
+            if (aTerms * bTerms[j] >= PARALLEL_TASK_MIN_TERMS) {
+                tasks[taskCount] = (PolyOpTask){.p = &a->arr[i].p, .q = &b->arr[j].p,
+                                                .index = i * b->size + j};
+                ThreadPoolSpawn(&group, RunMulTask, &tasks[taskCount++]);
+            }
+        }
+    }
+    for (size_t i = 0, k = 0; i < a->size; i++) {
+        for (size_t j = 0; j < b->size; j++) {
+            if (k < taskCount && tasks[k].index == i * b->size + j) {
+                k++;
+            } else {
+                products[i * b->size + j] = PolyMul(&a->arr[i].p, &b->arr[j].p);
+            }
+        }
+    }
+
+    ThreadPoolWait(&group);
+    for (size_t k = 0; k < taskCount; k++) {
+        products[tasks[k].index] = tasks[k].result;
+    }
+    free(tasks);
+    free(bTerms);
+
+    return products;
 }
 
 /**
  * Mnoży dwa wielomiany niestałe - takie, które nie są współczynnikami.
+ * Iloczyny jednomianów są generowane w kolejności rosnących wykładników przez
+ * scalanie przy użyciu kopca (algorytm Johnsona): dla każdego jednomianu
+ * krótszego czynnika kopiec trzyma jego kolejny, jeszcze niewykorzystany
+ * iloczyn z jednomianem dłuższego czynnika. Iloczyny o równych wykładnikach są
+ * sumowane od razu, więc pamięć pomocnicza ma rozmiar krótszego czynnika,
+ * a wynik nie wymaga sortowania.
  * @param p : wielomian o niezerowym wykładniku @f$p@f$,
  * @param q : wielomian o niezerowym wykładniku @f$q@f$,
  * @return @f$p \cdot q@f$.
  */
-static inline Poly MultiplyNonCoeffs(const Poly *p, const Poly *q) {
+static Poly MultiplyNonCoeffs(const Poly *p, const Poly *q) {
     assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
 
-    size_t count = p->size * q->size;
-    Mono *monos = SafeMalloc(count * sizeof(Mono));
+    const Poly *a = p->size <= q->size ? p : q;
+    const Poly *b = p->size <= q->size ? q : p;
+    Poly *products = NULL;
+    if (IsParallel() && a->size * b->size <= PARALLEL_MUL_MAX_PAIRS) {
+        products = MultiplyCoeffPairs(a, b);
+    }
+
+    size_t heapSize = a->size;
+    MulHeapEntry *heap = SafeMalloc(heapSize * sizeof(MulHeapEntry));
+    for (size_t i = 0; i < heapSize; i++) { // Wykładniki a rosną, więc to już jest kopiec.
+        heap[i] = (MulHeapEntry){.exp = a->arr[i].exp + b->arr[0].exp, .aIndex = i, .bIndex = 0};
+    }
+
+    size_t count = 0, capacity = a->size + b->size;
+    Mono *monos = SafeMonoArrayAlloc(capacity);
+    Poly sum = PolyZero();
+    poly_exp_t sumExp = heap[0].exp;
+
+    while (heapSize > 0) {
+        MulHeapEntry top = heap[0];
 
-    for (size_t pIndex = 0, monosIndex = 0; pIndex < p->size; pIndex++) {
-        for (size_t qIndex = 0; qIndex < q->size; qIndex++, monosIndex++) {
-            monos[monosIndex] = MonoMul(&p->arr[pIndex], &q->arr[qIndex]);
+        if (top.exp != sumExp) {
+            if (!PolyIsZero(&sum)) {
+                AppendMono(&monos, &count, &capacity, MonoFromPoly(&sum, sumExp));
+            }
+            sum = PolyZero();
+            sumExp = top.exp;
+        }
+
+        Poly product = products != NULL ? products[top.aIndex * b->size + top.bIndex]
+                                        : PolyMul(&a->arr[top.aIndex].p, &b->arr[top.bIndex].p);
+        sum = PolyAddMove(&sum, &product);
+
+        if (top.bIndex + 1 < b->size) {
+            heap[0].bIndex++;
+            heap[0].exp = a->arr[top.aIndex].exp + b->arr[top.bIndex + 1].exp;
+        } else {
+            heap[0] = heap[--heapSize];
         }
+        MulHeapSiftDown(heap, heapSize, 0);
+    }
+    if (!PolyIsZero(&sum)) {
+        AppendMono(&monos, &count, &capacity, MonoFromPoly(&sum, sumExp));
     }
+    free(heap);
+    free(products);
 
-    Poly result = PolyAddMonos(count, monos);
-    free(monos);
+    return PolyFromSortedMonos(count, capacity, monos);
+}
 
-    return result;
+/**
+ * Długość czynników, poniżej której mnożymy tablice współczynników
+ * szkolnym algorytmem zamiast algorytmem Karacuby.
+ */
+#define KARATSUBA_THRESHOLD 32
+
+/**
+ * Mnoży szkolnym algorytmem dwie tablice współczynników.
+ * @param a : pierwszy czynnik,
+ * @param n : długość pierwszego czynnika,
+ * @param b : drugi czynnik,
+ * @param m : długość drugiego czynnika,
+ * @param result : tablica długości @f$n + m - 1@f$ na iloczyn.
+ */
+static void SchoolbookMultiply(const unsigned long *a, size_t n, const unsigned long *b, size_t m,
+                               unsigned long *result) {
+    memset(result, 0, (n + m - 1) * sizeof(unsigned long));
+    if (CoeffRingIsModular()) {
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < m; j++) {
+                result[i + j] = CoeffAdd(result[i + j], CoeffMul(a[i], b[j]));
+            }
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < m; j++) {
+            result[i + j] += a[i] * b[j];
+        }
+    }
 }
 
 /**
- * Mnoży dwa wielomiany, pierwszym z nie jest wielomianem stałym, a drugi jest.
+ * Mnoży algorytmem Karacuby dwie tablice współczynników tej samej długości.
+ * Czynniki są dzielone na dolne połowy długości @f$h@f$ i górne połowy,
+ * a iloczyn wyznaczany z trzech iloczynów połówek
+ * @f$a_0 b_0@f$, @f$a_1 b_1@f$ i @f$(a_0 + a_1)(b_0 + b_1)@f$.
+ * Używa tylko dodawania, odejmowania i mnożenia, więc daje dokładny wynik
+ * w każdym pierścieniu współczynników.
+ * @param a : pierwszy czynnik,
+ * @param b : drugi czynnik,
+ * @param n : długość czynników,
+ * @param result : tablica długości @f$2n - 1@f$ na iloczyn,
+ * @param scratch : pamięć pomocnicza długości co najmniej
+ * @f$4n + 4\lceil\log_2 n\rceil@f$.
+ */
+static void KaratsubaMultiply(const unsigned long *a, const unsigned long *b, size_t n,
+                              unsigned long *result, unsigned long *scratch) {
+    if (n < KARATSUBA_THRESHOLD) {
+        SchoolbookMultiply(a, n, b, n, result);
+        return;
+    }
+
+    size_t low = n / 2, high = n - low;
+    unsigned long *aSum = scratch, *bSum = scratch + high, *middle = scratch + 2 * high;
+    unsigned long *rest = middle + 2 * high;
+
+    KaratsubaMultiply(a, b, low, result, rest);
+    result[2 * low - 1] = 0;
+    KaratsubaMultiply(a + low, b + low, high, result + 2 * low, rest);
+
+    for (size_t i = 0; i < high; i++) {
+        aSum[i] = CoeffAdd(a[low + i], i < low ? a[i] : 0);
+        bSum[i] = CoeffAdd(b[low + i], i < low ? b[i] : 0);
+    }
+    KaratsubaMultiply(aSum, bSum, high, middle, rest);
+
+    for (size_t i = 0; i < 2 * low - 1; i++) {
+        middle[i] = CoeffSub(middle[i], result[i]);
+    }
+    for (size_t i = 0; i < 2 * high - 1; i++) {
+        middle[i] = CoeffSub(middle[i], result[2 * low + i]);
+    }
+    for (size_t i = 0; i < 2 * high - 1; i++) {
+        result[low + i] = CoeffAdd(result[low + i], middle[i]);
+    }
+}
+
+/**
+ * Długość krótszego czynnika, od której w trybie modularnym mnożymy tablice
+ * współczynników transformatą teoretyczno-liczbową.
+ */
+#define NTT_THRESHOLD 64
+
+/**
+ * Mnoży dwie tablice współczynników dowolnych długości. W trybie modularnym
+ * długie czynniki są mnożone transformatą teoretyczno-liczbową, jeśli moduł
+ * na to pozwala. W przeciwnym przypadku dłuższy czynnik jest dzielony na
+ * bloki długości krótszego, a każdy blok mnożony algorytmem Karacuby.
+ * @param a : pierwszy czynnik,
+ * @param n : długość pierwszego czynnika,
+ * @param b : drugi czynnik,
+ * @param m : długość drugiego czynnika,
+ * @param result : tablica długości @f$n + m - 1@f$ na iloczyn.
+ */
+static void DenseMultiply(const unsigned long *a, size_t n, const unsigned long *b, size_t m,
+                          unsigned long *result) {
+    if (n > m) {
+        DenseMultiply(b, m, a, n, result);
+        return;
+    }
+    if (n >= NTT_THRESHOLD && CoeffRingNttMultiply(a, n, b, m, result)) {
+        return;
+    }
+    if (n < KARATSUBA_THRESHOLD) {
+        SchoolbookMultiply(a, n, b, m, result);
+        return;
+    }
+
+    unsigned long *block = SafeMalloc(n * sizeof(unsigned long));
+    unsigned long *product = SafeMalloc((2 * n - 1) * sizeof(unsigned long));
+    unsigned long *scratch = SafeMalloc((4 * n + 4 * 64) * sizeof(unsigned long));
+
+    memset(result, 0, (n + m - 1) * sizeof(unsigned long));
+    for (size_t offset = 0; offset < m; offset += n) {
+        size_t length = m - offset < n ? m - offset : n;
+        memcpy(block, b + offset, length * sizeof(unsigned long));
+        memset(block + length, 0, (n - length) * sizeof(unsigned long));
+        KaratsubaMultiply(a, block, n, product, scratch);
+        for (size_t i = 0; i < n + length - 1; i++) {
+            result[offset + i] = CoeffAdd(result[offset + i], product[i]);
+        }
+    }
+
+    free(block);
+    free(product);
+    free(scratch);
+}
+
+/**
+ * Sprawdza, czy wielomian jest gęstym wielomianem jednej zmiennej: wszystkie
+ * jego współczynniki są liczbami, a co najmniej połowa wykładników od 0 do
+ * stopnia występuje w nim.
+ * @param p : wielomian niebędący współczynnikiem,
+ * @return Czy wielomian warto mnożyć jako tablicę współczynników?
+ */
+static bool PolyIsDenseLeaf(const Poly *p) {
+    assert(!PolyIsCoeff(p));
+
+    if ((size_t)MonoGetExp(&p->arr[p->size - 1]) >= 2 * p->size) {
+        return false;
+    }
+    for (size_t i = 0; i < p->size; i++) {
+        if (!PolyIsCoeff(&p->arr[i].p)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Zamienia gęsty wielomian jednej zmiennej na tablicę współczynników.
+ * @param p : gęsty wielomian jednej zmiennej,
+ * @param length : wskaźnik na zapisanie długości tablicy,
+ * @return tablica współczynników przy kolejnych potęgach.
+ */
+static unsigned long *DenseLeafToArray(const Poly *p, size_t *length) {
+    *length = (size_t)MonoGetExp(&p->arr[p->size - 1]) + 1;
+    unsigned long *coeffs = SafeCalloc(*length, sizeof(unsigned long));
+
+    for (size_t i = 0; i < p->size; i++) {
+        coeffs[MonoGetExp(&p->arr[i])] = (unsigned long)p->arr[i].p.coeff;
+    }
+    return coeffs;
+}
+
+/**
+ * Próbuje pomnożyć dwa wielomiany, traktując je jako gęste tablice
+ * współczynników jednej zmiennej.
  * @param p : wielomian niebędący współczynnikiem @f$p@f$,
- * @param q : wielomian stały @f$q@f$,
- * @return @f$p \cdot q@f$.
+ * @param q : wielomian niebędący współczynnikiem @f$q@f$,
+ * @param result : wskaźnik na zapisanie @f$p \cdot q@f$,
+ * @return false, jeśli któryś z czynników nie jest gęsty albo jest krótki.
  */
-static inline Poly MultiplyPolyByCoeff(const Poly *p, const Poly *q) {
-    assert(!PolyIsCoeff(p) && PolyIsCoeff(q));
+static bool MultiplyDenseLeaves(const Poly *p, const Poly *q, Poly *result) {
+    if (p->size < KARATSUBA_THRESHOLD || q->size < KARATSUBA_THRESHOLD ||
+        !PolyIsDenseLeaf(p) || !PolyIsDenseLeaf(q)) {
+        return false;
+    }
 
-    if (PolyIsZero(q)) {
-        return PolyZero();
+    size_t n, m;
+    unsigned long *a = DenseLeafToArray(p, &n), *b = DenseLeafToArray(q, &m);
+    unsigned long *product = SafeMalloc((n + m - 1) * sizeof(unsigned long));
+    DenseMultiply(a, n, b, m, product);
+    free(a);
+    free(b);
+
+    size_t count = 0;
+    for (size_t i = 0; i < n + m - 1; i++) {
+        count += product[i] != 0;
     }
+    Mono *monos = SafeMonoArrayAlloc(count);
+    for (size_t i = 0, monosI = 0; i < n + m - 1; i++) {
+        if (product[i] != 0) {
+            Poly coeff = PolyFromCoeff((poly_coeff_t)product[i]);
+            monos[monosI++] = MonoFromPoly(&coeff, (poly_exp_t)i);
+        }
+    }
+    free(product);
 
-    const Mono constValue = MonoFromPoly(q, 0);
-    Poly newPoly = {.size = p->size, .arr = SafeMalloc(p->size * sizeof(Mono))};
-    size_t newPolyI = 0;
+    *result = PolyFromSortedMonos(count, count, monos);
+    return true;
+}
+
+/**
+ * Minimalna liczba iloczynów par składników, od której mnożenie wielomianów
+ * niestałych wykonujemy przez podstawienie Kroneckera.
+ */
+#define KRONECKER_MIN_PRODUCTS 256
+
+/**
+ * Największa długość tablicy, w której podstawienie Kroneckera sumuje
+ * iloczyny bezpośrednio pod indeksem spakowanego wykładnika.
+ */
+#define KRONECKER_DENSE_LIMIT ((uint64_t)1 << 22)
+
+/**
+ * Składnik wielomianu w postaci spłaszczonej: współczynnik liczbowy i wektor
+ * wykładników wszystkich zmiennych spakowany do jednej liczby.
+ */
+typedef struct {
+    uint64_t exp;       ///< spakowany wektor wykładników
+    poly_coeff_t coeff; ///< współczynnik
+} PackedTerm;
+
+/**
+ * Opis pakowania wektora wykładników do jednej liczby. Wykładnik zmiennej
+ * @f$x_i@f$ jest mnożony przez `strides[i]`, a `bases[i]` jest większe od
+ * każdego wykładnika tej zmiennej, który może się pojawić. Zmienna
+ * @f$x_0@f$ jest najbardziej znacząca, więc kolejność spakowanych wykładników
+ * zgadza się z kolejnością jednomianów w drzewie wielomianu.
+ */
+typedef struct {
+    size_t vars;       ///< liczba zmiennych
+    uint64_t *bases;   ///< podstawy kolejnych zmiennych
+    uint64_t *strides; ///< wagi kolejnych zmiennych
+} KroneckerPacking;
+
+/**
+ * Zwraca liczbę zmiennych, od których zależy wielomian, czyli głębokość jego
+ * drzewa.
+ * @param p : wielomian,
+ * @return głębokość wielomianu @p p.
+ */
+static size_t PolyVarCount(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return 0;
+    }
 
+    size_t max = 0;
     for (size_t i = 0; i < p->size; i++) {
-        Mono tmp = MonoMul(&p->arr[i], &constValue);
-        if (!MonoIsZero(&tmp)) {
-            newPoly.arr[newPolyI++] = tmp;
+        size_t curr = PolyVarCount(&p->arr[i].p);
+        if (curr > max) {
+            max = curr;
         }
     }
-    newPoly.size = newPolyI;
+    return max + 1;
+}
 
-    if (newPoly.size == 0) {
-        PolyDestroy(&newPoly);
-        return PolyZero();
+/**
+ * Wyznacza podstawy i wagi pakowania dla iloczynu @f$p \cdot q@f$ na
+ * podstawie stopni czynników względem każdej zmiennej.
+ * @param p : wielomian @f$p@f$,
+ * @param q : wielomian @f$q@f$,
+ * @param packing : wskaźnik na zapisanie opisu pakowania,
+ * @return false, jeśli spakowane wykładniki iloczynu nie mieszczą się
+ * w 63 bitach.
+ */
+static bool KroneckerPackingInit(const Poly *p, const Poly *q, KroneckerPacking *packing) {
+    size_t pVars = PolyVarCount(p), qVars = PolyVarCount(q);
+    packing->vars = pVars > qVars ? pVars : qVars;
+    packing->bases = SafeMalloc(packing->vars * sizeof(uint64_t));
+    packing->strides = SafeMalloc(packing->vars * sizeof(uint64_t));
+
+    for (size_t var = 0; var < packing->vars; var++) {
+        packing->bases[var] = (uint64_t)PolyDegBy(p, var) + (uint64_t)PolyDegBy(q, var) + 1;
     }
 
-    return newPoly;
+    uint64_t stride = 1;
+    for (size_t var = packing->vars; var-- > 0;) {
+        packing->strides[var] = stride;
+        if (stride > (UINT64_MAX >> 1) / packing->bases[var]) {
+            free(packing->bases);
+            free(packing->strides);
+            return false;
+        }
+        stride *= packing->bases[var];
+    }
+
+    return true;
 }
 
-Poly PolyMul(const Poly *p, const Poly *q) {
-    if (PolyIsCoeff(p) && PolyIsCoeff(q)) { // Obydwa są współczynnikami.
-        return MultiplyCoeffs(p, q);
-    } else if (!PolyIsCoeff(p) && !PolyIsCoeff(q)) { // Obydwa nie są współczynnikami.
-        return MultiplyNonCoeffs(p, q);
-    } else if (!PolyIsCoeff(p) && PolyIsCoeff(q)) { // Jeden jest współczynnikiem, a drugi nie.
-        return MultiplyPolyByCoeff(p, q);
-    } else {
-        return MultiplyPolyByCoeff(q, p);
+/**
+ * Zwalnia pamięć po opisie pakowania.
+ * @param packing : opis pakowania.
+ */
+static void KroneckerPackingDestroy(KroneckerPacking *packing) {
+    free(packing->bases);
+    free(packing->strides);
+}
+
+/**
+ * Spłaszcza drzewo wielomianu do tablicy składników posortowanej rosnąco po
+ * spakowanych wykładnikach.
+ * @param p : wielomian,
+ * @param var : indeks zmiennej głównej wielomianu @p p,
+ * @param prefix : spakowane wykładniki zmiennych o mniejszych indeksach,
+ * @param packing : opis pakowania,
+ * @param terms : tablica na składniki,
+ * @param count : wskaźnik na liczbę zapisanych składników.
+ */
+static void PackTerms(const Poly *p, size_t var, uint64_t prefix,
+                      const KroneckerPacking *packing, PackedTerm *terms, size_t *count) {
+    if (PolyIsCoeff(p)) {
+        if (!PolyIsZero(p)) {
+            terms[(*count)++] = (PackedTerm){.exp = prefix, .coeff = p->coeff};
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < p->size; i++) {
+        uint64_t exp = prefix + (uint64_t)MonoGetExp(&p->arr[i]) * packing->strides[var];
+        PackTerms(&p->arr[i].p, var + 1, exp, packing, terms, count);
     }
 }
 
 /**
- * Podnosi daną liczbę do potęgi wykorzystując szybkie potęgowanie binarne.
- * @param x : podstawa @f$x@f$,
- * @param n : wykładnik @f$n@f$,
- * @return @f$x ^ n@f$.
+ * Odtwarza drzewo wielomianu z tablicy niezerowych składników posortowanej
+ * rosnąco po spakowanych wykładnikach.
+ * @param terms : tablica składników,
+ * @param count : liczba składników,
+ * @param var : indeks zmiennej głównej tworzonego wielomianu,
+ * @param packing : opis pakowania,
+ * @return wielomian będący sumą składników.
  */
-static inline poly_coeff_t RaiseToPower(poly_coeff_t x, poly_exp_t n) {
-    if (n == 0) {
-        return 1;
+static Poly UnpackTerms(const PackedTerm *terms, size_t count, size_t var,
+                        const KroneckerPacking *packing) {
+    if (var == packing->vars) {
+        assert(count == 1);
+        return PolyFromCoeff(terms[0].coeff);
     }
 
-    poly_coeff_t res = 1;
-    while (n > 0) {
-        if (n & 1) {
-            res *= x;
+    uint64_t stride = packing->strides[var], base = packing->bases[var];
+    size_t groups = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i == 0 || (terms[i].exp / stride) % base != (terms[i - 1].exp / stride) % base) {
+            groups++;
         }
+    }
 
-        x *= x;
-        n >>= 1;
+    Mono *monos = SafeMonoArrayAlloc(groups);
+    size_t monosI = 0;
+    for (size_t begin = 0, end; begin < count; begin = end) {
+        uint64_t exp = (terms[begin].exp / stride) % base;
+        for (end = begin + 1; end < count && (terms[end].exp / stride) % base == exp; end++) {
+        }
+        Poly child = UnpackTerms(terms + begin, end - begin, var + 1, packing);
+        monos[monosI++] = MonoFromPoly(&child, (poly_exp_t)exp);
     }
 
-    return res;
+    return PolyFromSortedMonos(groups, groups, monos);
 }
 
-Poly PolyAt(const Poly *p, poly_coeff_t x) {
-    if (PolyIsCoeff(p)) {
-        return PolyFromCoeff(p->coeff);
+/**
+ * Mnoży dwie tablice składników, sumując iloczyny w tablicy indeksowanej
+ * spakowanym wykładnikiem. Poza trybem modularnym arytmetyka na typie bez
+ * znaku daje te same wyniki modulo @f$2^{64}@f$ co mnożenie rekurencyjne, ale
+ * bez niezdefiniowanego zachowania przy przepełnieniu.
+ * @param a : pierwsza tablica składników,
+ * @param n : rozmiar pierwszej tablicy,
+ * @param b : druga tablica składników,
+ * @param m : rozmiar drugiej tablicy,
+ * @param range : długość tablicy sum, większa od każdego wykładnika iloczynu,
+ * @param count : wskaźnik na zapisanie liczby składników iloczynu,
+ * @return tablica niezerowych składników iloczynu.
+ */
+static PackedTerm *MultiplyPackedDense(const PackedTerm *a, size_t n, const PackedTerm *b,
+                                       size_t m, uint64_t range, size_t *count) {
+    unsigned long *sums = SafeCalloc(range, sizeof(unsigned long));
+
+    for (size_t i = 0; i < n; i++) {
+        unsigned long aCoeff = (unsigned long)a[i].coeff;
+        unsigned long *row = sums + a[i].exp;
+        if (CoeffRingIsModular()) {
+            for (size_t j = 0; j < m; j++) {
+                row[b[j].exp] = CoeffAdd(row[b[j].exp], CoeffMul(aCoeff, (unsigned long)b[j].coeff));
+            }
+        } else {
+            for (size_t j = 0; j < m; j++) {
+                row[b[j].exp] += aCoeff * (unsigned long)b[j].coeff;
+            }
+        }
+    }
+
+    *count = 0;
+    for (uint64_t exp = 0; exp < range; exp++) {
+        *count += sums[exp] != 0;
+    }
+    PackedTerm *result = SafeMalloc((*count > 0 ? *count : 1) * sizeof(PackedTerm));
+    for (uint64_t exp = 0, i = 0; exp < range; exp++) {
+        if (sums[exp] != 0) {
+            result[i++] = (PackedTerm){.exp = exp, .coeff = (poly_coeff_t)sums[exp]};
+        }
     }
+    free(sums);
 
-    Poly newPoly = PolyZero();
+    return result;
+}
 
-    for (size_t i = 0; i < p->size; i++) {
-        Poly polyToPower = PolyFromCoeff(RaiseToPower(x, p->arr[i].exp));
-        Poly multiplyResult = PolyMul(&p->arr[i].p, &polyToPower);
-        PolyDestroy(&polyToPower);
-        Poly tmp = newPoly;
-        newPoly = PolyAdd(&newPoly, &multiplyResult);
-        PolyDestroy(&multiplyResult);
-        PolyDestroy(&tmp);
+/**
+ * Mnoży dwie tablice składników, których spakowane wykładniki wypełniają
+ * gęsto swój zakres: rozpakowuje je do tablic współczynników indeksowanych
+ * wykładnikiem i mnoży algorytmem Karacuby.
+ * @param a : pierwsza tablica składników,
+ * @param n : rozmiar pierwszej tablicy,
+ * @param b : druga tablica składników,
+ * @param m : rozmiar drugiej tablicy,
+ * @param count : wskaźnik na zapisanie liczby składników iloczynu,
+ * @return tablica niezerowych składników iloczynu.
+ */
+static PackedTerm *MultiplyPackedKaratsuba(const PackedTerm *a, size_t n, const PackedTerm *b,
+                                           size_t m, size_t *count) {
+    size_t aLength = a[n - 1].exp + 1, bLength = b[m - 1].exp + 1;
+    unsigned long *aCoeffs = SafeCalloc(aLength, sizeof(unsigned long));
+    unsigned long *bCoeffs = SafeCalloc(bLength, sizeof(unsigned long));
+    unsigned long *product = SafeMalloc((aLength + bLength - 1) * sizeof(unsigned long));
+
+    for (size_t i = 0; i < n; i++) {
+        aCoeffs[a[i].exp] = (unsigned long)a[i].coeff;
     }
+    for (size_t i = 0; i < m; i++) {
+        bCoeffs[b[i].exp] = (unsigned long)b[i].coeff;
+    }
+    DenseMultiply(aCoeffs, aLength, bCoeffs, bLength, product);
+    free(aCoeffs);
+    free(bCoeffs);
 
-    return newPoly;
+    *count = 0;
+    for (size_t exp = 0; exp < aLength + bLength - 1; exp++) {
+        *count += product[exp] != 0;
+    }
+    PackedTerm *result = SafeMalloc((*count > 0 ? *count : 1) * sizeof(PackedTerm));
+    for (size_t exp = 0, i = 0; exp < aLength + bLength - 1; exp++) {
+        if (product[exp] != 0) {
+            result[i++] = (PackedTerm){.exp = exp, .coeff = (poly_coeff_t)product[exp]};
+        }
+    }
+    free(product);
+
+    return result;
+}
+
+/**
+ * Element kopca używanego przy mnożeniu tablic składników.
+ */
+typedef struct {
+    uint64_t exp;  ///< spakowany wykładnik iloczynu
+    size_t aIndex; ///< indeks składnika krótszej tablicy
+    size_t bIndex; ///< indeks składnika dłuższej tablicy
+} PackedHeapEntry;
+
+/**
+ * Przywraca własność kopca minimalnego, przesuwając element z pozycji @p i
+ * w dół.
+ * @param heap : kopiec,
+ * @param size : rozmiar kopca,
+ * @param i : indeks przesuwanego elementu.
+ */
+static void PackedHeapSiftDown(PackedHeapEntry *heap, size_t size, size_t i) {
+    PackedHeapEntry entry = heap[i];
+
+    while (2 * i + 1 < size) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < size && heap[child + 1].exp < heap[child].exp) {
+            child++;
+        }
+        if (heap[child].exp >= entry.exp) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = entry;
+}
+
+/**
+ * Mnoży dwie tablice składników, scalając iloczyny kopcem tak samo jak
+ * MultiplyNonCoeffs, ale bez rekurencji i alokacji dla każdego iloczynu.
+ * @param a : krótsza tablica składników,
+ * @param n : rozmiar krótszej tablicy,
+ * @param b : dłuższa tablica składników,
+ * @param m : rozmiar dłuższej tablicy,
+ * @param count : wskaźnik na zapisanie liczby składników iloczynu,
+ * @return tablica niezerowych składników iloczynu.
+ */
+static PackedTerm *MultiplyPackedHeap(const PackedTerm *a, size_t n, const PackedTerm *b,
+                                      size_t m, size_t *count) {
+    assert(n <= m);
+
+    PackedHeapEntry *heap = SafeMalloc(n * sizeof(PackedHeapEntry));
+    for (size_t i = 0; i < n; i++) {
+        heap[i] = (PackedHeapEntry){.exp = a[i].exp + b[0].exp, .aIndex = i, .bIndex = 0};
+    }
+
+    size_t heapSize = n, capacity = n + m;
+    PackedTerm *result = SafeMalloc(capacity * sizeof(PackedTerm));
+    *count = 0;
+
+    while (heapSize > 0) {
+        uint64_t exp = heap[0].exp;
+        unsigned long sum = 0;
+
+        while (heapSize > 0 && heap[0].exp == exp) {
+            PackedHeapEntry *top = &heap[0];
+            sum = CoeffAdd(sum, CoeffMul((unsigned long)a[top->aIndex].coeff,
+                                         (unsigned long)b[top->bIndex].coeff));
+            if (++top->bIndex < m) {
+                top->exp = a[top->aIndex].exp + b[top->bIndex].exp;
+            } else {
+                heap[0] = heap[--heapSize];
+            }
+            PackedHeapSiftDown(heap, heapSize, 0);
+        }
+
+        if (sum != 0) {
+            if (*count == capacity) {
+                capacity *= 2;
+                result = SafeRealloc(result, capacity * sizeof(PackedTerm));
+            }
+            result[(*count)++] = (PackedTerm){.exp = exp, .coeff = (poly_coeff_t)sum};
+        }
+    }
+    free(heap);
+
+    return result;
+}
+
+/**
+ * Próbuje pomnożyć dwa wielomiany niestałe przez podstawienie Kroneckera:
+ * oba drzewa są spłaszczane do tablic składników z wykładnikami spakowanymi
+ * w jedną liczbę, tablice są mnożone jak wielomiany jednej zmiennej, a wynik
+ * jest z powrotem zamieniany na drzewo.
+ * @param p : wielomian niebędący współczynnikiem @f$p@f$,
+ * @param q : wielomian niebędący współczynnikiem @f$q@f$,
+ * @param result : wskaźnik na zapisanie @f$p \cdot q@f$,
+ * @return false, jeśli metoda się nie opłaca albo wykładniki się nie mieszczą.
+ */
+static bool MultiplyKronecker(const Poly *p, const Poly *q, Poly *result) {
+    assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
+
+    size_t n = PolyTermCount(p), m = PolyTermCount(q);
+    if (n * m < KRONECKER_MIN_PRODUCTS) {
+        return false;
+    }
+
+    KroneckerPacking packing;
+    if (!KroneckerPackingInit(p, q, &packing)) {
+        return false;
+    }
+
+    PackedTerm *a = SafeMalloc(n * sizeof(PackedTerm));
+    PackedTerm *b = SafeMalloc(m * sizeof(PackedTerm));
+    size_t aCount = 0, bCount = 0;
+    PackTerms(p, 0, 0, &packing, a, &aCount);
+    PackTerms(q, 0, 0, &packing, b, &bCount);
+    if (n > m) {
+        PackedTerm *tmp = a;
+        a = b;
+        b = tmp;
+        size_t tmpCount = n;
+        n = m;
+        m = tmpCount;
+    }
+
+    size_t count;
+    PackedTerm *terms;
+    uint64_t range = a[n - 1].exp + b[m - 1].exp + 1;
+    if (range <= KRONECKER_DENSE_LIMIT && n >= KARATSUBA_THRESHOLD &&
+        a[n - 1].exp < 4 * n && b[m - 1].exp < 4 * m) {
+        terms = MultiplyPackedKaratsuba(a, n, b, m, &count);
+    } else if (range <= KRONECKER_DENSE_LIMIT && range / 4 <= (uint64_t)n * m) {
+        terms = MultiplyPackedDense(a, n, b, m, range, &count);
+    } else {
+        terms = MultiplyPackedHeap(a, n, b, m, &count);
+    }
+    free(a);
+    free(b);
+
+    *result = count == 0 ? PolyZero() : UnpackTerms(terms, count, 0, &packing);
+    free(terms);
+    KroneckerPackingDestroy(&packing);
+
+    return true;
+}
+
+/**
+ * Mnoży dwa wielomiany, pierwszym z nie jest wielomianem stałym, a drugi jest.
+ * @param p : wielomian niebędący współczynnikiem @f$p@f$,
+ * @param q : wielomian stały @f$q@f$,
+ * @return @f$p \cdot q@f$.
+ */
+static inline Poly MultiplyPolyByCoeff(const Poly *p, const Poly *q) {
+    assert(!PolyIsCoeff(p) && PolyIsCoeff(q));
+
+    if (PolyIsZero(q)) {
+        return PolyZero();
+    }
+
+    const Mono constValue = MonoFromPoly(q, 0);
+    Poly newPoly = {.size = p->size, .arr = SafeMonoArrayAlloc(p->size)};
+    size_t newPolyI = 0;
+
+    TaskGroup group = {.pending = 0};
+    PolyOpTask *tasks = IsParallel() ? SafeMalloc(p->size * sizeof(PolyOpTask)) : NULL;
+    size_t taskCount = 0;
+
+    for (size_t i = 0; i < p->size; i++) {
+        if (tasks != NULL &&
+            PolyTermCountUpTo(&p->arr[i].p, PARALLEL_TASK_MIN_TERMS) >= PARALLEL_TASK_MIN_TERMS) {
+            tasks[taskCount] = (PolyOpTask){.p = &p->arr[i].p, .q = q, .index = newPolyI};
+            newPoly.arr[newPolyI++] = (Mono){.exp = p->arr[i].exp, .p = PolyZero()};
+            ThreadPoolSpawn(&group, RunMulTask, &tasks[taskCount++]);
+            continue;
+        }
+
+        Mono tmp = MonoMul(&p->arr[i], &constValue);
+        if (!MonoIsZero(&tmp)) {
+            newPoly.arr[newPolyI++] = tmp;
+        }
+    }
+    newPolyI = CollectTaskResults(&group, tasks, taskCount, newPoly.arr, newPolyI);
+    free(tasks);
+    newPoly.size = newPolyI;
+
+    if (newPoly.size == 0) {
+        PolyDestroy(&newPoly);
+        return PolyZero();
+    }
+
+    return newPoly;
+}
+
+/**
+ * Liczba iloczynów składników, od której mnożenie jest dzielone między wątki.
+ */
+#define PARALLEL_MUL_MIN_PRODUCTS (1 << 16)
+
+/**
+ * Liczba fragmentów dzielonego czynnika przypadająca na jeden wątek. Więcej fragmentów niż
+ * wątków wyrównuje obciążenie, gdy fragmenty mnożą się w różnym czasie.
+ */
+#define PARALLEL_CHUNKS_PER_THREAD 4
+
+/**
+ * Zadanie mnożenia fragmentu jednego czynnika przez drugi czynnik.
+ */
+typedef struct {
+    Poly chunk;         ///< widok na kolejne jednomiany dzielonego czynnika
+    const Poly *other;  ///< drugi czynnik
+    Poly result;        ///< iloczyn fragmentu i drugiego czynnika
+} MulChunkTask;
+
+/**
+ * Zadanie scalenia dwóch iloczynów częściowych.
+ */
+typedef struct {
+    Poly *sum;    ///< pierwszy składnik, w którym zapisywana jest suma
+    Poly *addend; ///< drugi składnik, zerowany po scaleniu
+} MergeTask;
+
+/**
+ * Wykonuje zadanie mnożenia fragmentu.
+ * @param arg : wskaźnik na MulChunkTask.
+ */
+static void RunMulChunkTask(void *arg) {
+    MulChunkTask *task = arg;
+    task->result = PolyMul(&task->chunk, task->other);
+}
+
+/**
+ * Wykonuje zadanie scalenia iloczynów częściowych.
+ * @param arg : wskaźnik na MergeTask.
+ */
+static void RunMergeTask(void *arg) {
+    MergeTask *task = arg;
+    *task->sum = PolyAddMove(task->sum, task->addend);
+}
+
+/**
+ * Sumuje wielomiany parami: w kolejnych rundach scala sąsiednie sumy częściowe, więc każdy
+ * jednomian jest przenoszony tylko @f$O(\log n)@f$ razy. Scalenia jednej rundy mogą być
+ * wykonywane równolegle. Przejmuje na własność zawartość tablicy @p polys.
+ * @param count : liczba wielomianów,
+ * @param polys : tablica wielomianów,
+ * @param parallel : czy zgłaszać scalenia jako zadania puli wątków,
+ * @return suma wielomianów.
+ */
+static Poly SumPolysMove(size_t count, Poly *polys, bool parallel) {
+    if (count == 0) {
+        return PolyZero();
+    }
+
+    TaskGroup group = {.pending = 0};
+    MergeTask *merges = parallel ? SafeMalloc((count / 2 + 1) * sizeof(MergeTask)) : NULL;
+    for (size_t step = 1; step < count; step *= 2) {
+        size_t mergeCount = 0;
+        for (size_t i = 0; i + step < count; i += 2 * step) {
+            if (merges != NULL) {
+                merges[mergeCount] = (MergeTask){.sum = &polys[i], .addend = &polys[i + step]};
+                ThreadPoolSpawn(&group, RunMergeTask, &merges[mergeCount++]);
+            } else {
+                polys[i] = PolyAddMove(&polys[i], &polys[i + step]);
+            }
+        }
+        ThreadPoolWait(&group);
+    }
+    free(merges);
+
+    return polys[0];
+}
+
+/**
+ * Próbuje pomnożyć dwa wielomiany niestałe na wielu wątkach. Dłuższy czynnik jest dzielony
+ * na fragmenty kolejnych jednomianów, każdy fragment jest mnożony przez drugi czynnik jako
+ * osobne zadanie, a iloczyny częściowe są scalane parami, również równolegle.
+ * Czynniki o niewielu jednomianach najwyższego poziomu zostawiamy zwykłemu wyborowi metody
+ * mnożenia w @ref PolyMul, bo podział na fragmenty nie dałby zadań dla wszystkich wątków.
+ * Jeśli żadna szczególna metoda ich nie obsłuży, to @ref MultiplyNonCoeffs i tak liczy
+ * iloczyny współczynników jako osobne zadania.
+ * @param p : wielomian niebędący współczynnikiem @f$p@f$,
+ * @param q : wielomian niebędący współczynnikiem @f$q@f$,
+ * @param result : wskaźnik na zapisanie @f$p \cdot q@f$,
+ * @return false, jeśli jest tylko jeden wątek albo czynniki są za małe lub za wąskie.
+ */
+static bool MultiplyInParallel(const Poly *p, const Poly *q, Poly *result) {
+    assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
+
+    size_t threads = ThreadPoolThreadCount();
+    const Poly *split = p->size >= q->size ? p : q;
+    const Poly *other = p->size >= q->size ? q : p;
+    if (threads <= 1 || p->size * q->size <= PARALLEL_MUL_MAX_PAIRS) {
+        return false;
+    }
+    // Liczba składników niestałego wielomianu jest dodatnia.
+    size_t n = PolyTermCountUpTo(p, PARALLEL_MUL_MIN_PRODUCTS);
+    size_t m = PolyTermCountUpTo(q, (PARALLEL_MUL_MIN_PRODUCTS + n - 1) / n);
+    if (n * m < PARALLEL_MUL_MIN_PRODUCTS) {
+        return false;
+    }
+
+    size_t chunkCount = threads * PARALLEL_CHUNKS_PER_THREAD;
+    if (chunkCount > split->size) {
+        chunkCount = split->size;
+    }
+
+    MulChunkTask *chunks = SafeMalloc(chunkCount * sizeof(MulChunkTask));
+    TaskGroup group = {.pending = 0};
+    for (size_t i = 0; i < chunkCount; i++) {
+        size_t begin = split->size * i / chunkCount, end = split->size * (i + 1) / chunkCount;
+        // Fragment dostaje własną tablicę z nagłówkiem; jej współczynniki są tylko pożyczone.
+        Mono *monos = SafeMonoArrayAlloc(end - begin);
+        memcpy(monos, split->arr + begin, (end - begin) * sizeof(Mono));
+        chunks[i] = (MulChunkTask){.chunk = {.size = end - begin, .arr = monos}, .other = other};
+        ThreadPoolSpawn(&group, RunMulChunkTask, &chunks[i]);
+    }
+    ThreadPoolWait(&group);
+
+    Poly *products = SafeMalloc(chunkCount * sizeof(Poly));
+    for (size_t i = 0; i < chunkCount; i++) {
+        MonoArrayFree(chunks[i].chunk.arr);
+        products[i] = chunks[i].result;
+    }
+    *result = SumPolysMove(chunkCount, products, true);
+    free(products);
+    free(chunks);
+
+    return true;
+}
+
+Poly PolyMul(const Poly *p, const Poly *q) {
+    if (PolyIsCoeff(p) && PolyIsCoeff(q)) { // Obydwa są współczynnikami.
+        return MultiplyCoeffs(p, q);
+    } else if (!PolyIsCoeff(p) && !PolyIsCoeff(q)) { // Obydwa nie są współczynnikami.
+        Poly result;
+        if (MultiplyInParallel(p, q, &result) || MultiplyDenseLeaves(p, q, &result) ||
+            MultiplyKronecker(p, q, &result)) {
+            return result;
+        }
+        return MultiplyNonCoeffs(p, q);
+    } else if (!PolyIsCoeff(p) && PolyIsCoeff(q)) { // Jeden jest współczynnikiem, a drugi nie.
+        return MultiplyPolyByCoeff(p, q);
+    } else {
+        return MultiplyPolyByCoeff(q, p);
+    }
+}
+
+/**
+ * Mnoży w miejscu wielomian niestały przez niezerowy współczynnik.
+ * Przejmuje na własność zawartość @p p.
+ * @param p : wielomian niebędący współczynnikiem,
+ * @param c : współczynnik,
+ * @return @f$c \cdot p@f$.
+ */
+static Poly MultiplyPolyByCoeffMove(Poly *p, poly_coeff_t c) {
+    assert(!PolyIsCoeff(p));
+
+    Poly result = *p;
+    *p = PolyZero();
+    Unshare(&result);
+    size_t count = 0;
+
+    for (size_t i = 0; i < result.size; i++) {
+        Poly coeff = PolyFromCoeff(c);
+        result.arr[i].p = PolyMulMove(&result.arr[i].p, &coeff);
+        if (!PolyIsZero(&result.arr[i].p)) {
+            result.arr[count++] = result.arr[i];
+        }
+    }
+
+    return PolyFromSortedMonos(count, result.size, result.arr);
+}
+
+Poly PolyMulMove(Poly *p, Poly *q) {
+    if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
+        Poly result = MultiplyCoeffs(p, q);
+        *p = PolyZero();
+        *q = PolyZero();
+        return result;
+    }
+    if (PolyIsCoeff(p) || PolyIsCoeff(q)) {
+        Poly *coeff = PolyIsCoeff(p) ? p : q, *poly = PolyIsCoeff(p) ? q : p;
+        poly_coeff_t c = coeff->coeff;
+        *coeff = PolyZero();
+        if (c == 0) {
+            PolyDestroy(poly);
+            *poly = PolyZero();
+            return PolyZero();
+        }
+        return MultiplyPolyByCoeffMove(poly, c);
+    }
+
+    Poly result = PolyMul(p, q);
+    PolyDestroy(p);
+    PolyDestroy(q);
+    *p = PolyZero();
+    *q = PolyZero();
+
+    return result;
+}
+
+/**
+ * Podnosi daną liczbę do potęgi w aktualnym pierścieniu współczynników,
+ * wykorzystując szybkie potęgowanie binarne.
+ * @param x : podstawa @f$x@f$,
+ * @param n : wykładnik @f$n@f$,
+ * @return @f$x ^ n@f$.
+ */
+static inline poly_coeff_t RaiseToPower(poly_coeff_t x, poly_exp_t n) {
+    return (poly_coeff_t)CoeffPow(CoeffFromLong(x), (unsigned long)n);
+}
+
+Poly PolyAt(const Poly *p, poly_coeff_t x) {
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff(p->coeff);
+    }
+
+    Poly *powers = SafeMalloc(p->size * sizeof(Poly));
+    PolyOpTask *tasks = SafeMalloc(p->size * sizeof(PolyOpTask));
+    TaskGroup group = {.pending = 0};
+    bool parallel = IsParallel() &&
+                    PolyTermCountUpTo(p, PARALLEL_TASK_MIN_TERMS) >= PARALLEL_TASK_MIN_TERMS;
+
+    // Wykładniki rosną, więc kolejną potęgę liczymy z poprzedniej i różnicy wykładników.
+    poly_coeff_t power = 1;
+    poly_exp_t powerExp = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        power = MulCoeffs(power, RaiseToPower(x, p->arr[i].exp - powerExp));
+        powerExp = p->arr[i].exp;
+        powers[i] = PolyFromCoeff(power);
+        tasks[i] = (PolyOpTask){.p = &p->arr[i].p, .q = &powers[i], .index = i};
+        if (parallel &&
+            PolyTermCountUpTo(&p->arr[i].p, PARALLEL_TASK_MIN_TERMS) >= PARALLEL_TASK_MIN_TERMS) {
+            ThreadPoolSpawn(&group, RunMulTask, &tasks[i]);
+        } else {
+            RunMulTask(&tasks[i]);
+        }
+    }
+    ThreadPoolWait(&group);
+
+    // Iloczyny sumujemy parami zamiast dopisywać je kolejno do coraz większej sumy.
+    for (size_t i = 0; i < p->size; i++) {
+        powers[i] = tasks[i].result;
+    }
+    Poly result = SumPolysMove(p->size, powers, parallel);
+    free(tasks);
+    free(powers);
+
+    return result;
+}
+
+/**
+ * Najmniejsza długość gęstej kolumny (patrz PolyAtMany), od której jej wartości w wielu punktach
+ * liczymy drzewem podiloczynów zamiast schematem Hornera dla każdego punktu osobno.
+ */
+#define MULTIPOINT_MIN_LENGTH 64
+
+/**
+ * Najmniejsza liczba punktów, dla której PolyAtMany buduje drzewo podiloczynów.
+ */
+#define MULTIPOINT_MIN_POINTS 16
+
+/**
+ * Największa liczba punktów liścia drzewa podiloczynów. W liściu wartości reszty są liczone
+ * schematem Hornera zamiast dalszego dzielenia.
+ */
+#define MULTIPOINT_LEAF_POINTS 8
+
+/**
+ * Długość ilorazu albo dzielnika, poniżej której resztę z dzielenia liczymy szkolnym
+ * algorytmem zamiast mnożenia przez odwrotność wyznaczoną iteracją Newtona.
+ */
+#define MULTIPOINT_NEWTON_THRESHOLD 64
+
+/**
+ * Węzeł drzewa podiloczynów: iloczyn @f$\prod_j (x - a_j)@f$ po punktach z zakresu węzła.
+ * Tablice współczynników są liczone w aktualnym pierścieniu współczynników.
+ */
+typedef struct SubproductNode {
+    size_t begin;                 ///< pierwszy punkt węzła
+    size_t end;                   ///< punkt za ostatnim punktem węzła
+    unsigned long *poly;          ///< iloczyn, długość @f$end - begin + 1@f$, unormowany
+    unsigned long *inverse;       ///< odwrotność odwróconego iloczynu albo NULL
+    size_t precision;             ///< liczba wyznaczonych wyrazów odwrotności
+    struct SubproductNode *left;  ///< lewe dziecko albo NULL w liściu
+    struct SubproductNode *right; ///< prawe dziecko albo NULL w liściu
+} SubproductNode;
+
+/**
+ * Buduje drzewo podiloczynów dla punktów z zakresu.
+ * @param points : punkty zredukowane do aktualnego pierścienia,
+ * @param begin : pierwszy punkt,
+ * @param end : punkt za ostatnim punktem,
+ * @return korzeń drzewa.
+ */
+static SubproductNode *BuildSubproductTree(const unsigned long *points, size_t begin,
+                                           size_t end) {
+    SubproductNode *node = SafeMalloc(sizeof(SubproductNode));
+    *node = (SubproductNode){.begin = begin, .end = end, .inverse = NULL, .precision = 0,
+                             .left = NULL, .right = NULL};
+    size_t degree = end - begin;
+    node->poly = SafeMalloc((degree + 1) * sizeof(unsigned long));
+
+    if (degree <= MULTIPOINT_LEAF_POINTS) {
+        // Mnożymy kolejno przez czynniki x - a_j.
+        node->poly[0] = CoeffFromLong(1);
+        for (size_t j = 0; j < degree; j++) {
+            node->poly[j + 1] = node->poly[j];
+            for (size_t i = j; i > 0; i--) {
+                node->poly[i] = CoeffSub(node->poly[i - 1],
+                                         CoeffMul(node->poly[i], points[begin + j]));
+            }
+            node->poly[0] = CoeffNeg(CoeffMul(node->poly[0], points[begin + j]));
+        }
+        return node;
+    }
+
+    size_t middle = begin + degree / 2;
+    node->left = BuildSubproductTree(points, begin, middle);
+    node->right = BuildSubproductTree(points, middle, end);
+    DenseMultiply(node->left->poly, middle - begin + 1, node->right->poly, end - middle + 1,
+                  node->poly);
+    return node;
+}
+
+/**
+ * Usuwa z pamięci drzewo podiloczynów.
+ * @param node : korzeń drzewa.
+ */
+static void DestroySubproductTree(SubproductNode *node) {
+    if (node->left != NULL) {
+        DestroySubproductTree(node->left);
+        DestroySubproductTree(node->right);
+    }
+    free(node->poly);
+    free(node->inverse);
+    free(node);
+}
+
+/**
+ * Wyznacza iteracją Newtona co najmniej @p precision wyrazów odwrotności szeregu potęgowego
+ * odwróconego iloczynu węzła. Iloczyn jest unormowany, więc odwrócony ma wyraz wolny 1 i jest
+ * odwracalny w każdym pierścieniu współczynników.
+ * @param node : węzeł drzewa podiloczynów,
+ * @param precision : liczba potrzebnych wyrazów.
+ */
+static void ExtendInverse(SubproductNode *node, size_t precision) {
+    if (node->precision >= precision) {
+        return;
+    }
+
+    size_t degree = node->end - node->begin;
+    size_t t = node->precision;
+    unsigned long *inverse = node->inverse;
+    if (t == 0) {
+        inverse = SafeMalloc(sizeof(unsigned long));
+        inverse[0] = CoeffFromLong(1);
+        t = 1;
+    }
+
+    unsigned long *reversed = SafeMalloc((degree + 1) * sizeof(unsigned long));
+    for (size_t i = 0; i <= degree; i++) {
+        reversed[i] = node->poly[degree - i];
+    }
+    while (t < precision) {
+        // Dla g * inv = 1 (mod x^t) mamy g * inv * (2 - g * inv) = 1 (mod x^2t).
+        size_t next = 2 * t < precision ? 2 * t : precision;
+        size_t length = degree + 1 < next ? degree + 1 : next;
+        unsigned long *error = SafeMalloc((length + t - 1 > next ? length + t - 1 : next) *
+                                          sizeof(unsigned long));
+        DenseMultiply(reversed, length, inverse, t, error);
+        for (size_t i = 0; i < next; i++) {
+            error[i] = i < length + t - 1 ? CoeffNeg(error[i]) : 0;
+        }
+        error[0] = CoeffAdd(error[0], CoeffFromLong(2));
+
+        unsigned long *product = SafeMalloc((t + next - 1) * sizeof(unsigned long));
+        DenseMultiply(inverse, t, error, next, product);
+        free(error);
+        free(inverse);
+        inverse = SafeRealloc(product, next * sizeof(unsigned long));
+        t = next;
+    }
+    free(reversed);
+
+    node->inverse = inverse;
+    node->precision = t;
+}
+
+/**
+ * Liczy resztę z dzielenia przez iloczyn węzła drzewa podiloczynów.
+ * @param f : dzielna,
+ * @param length : długość dzielnej,
+ * @param node : węzeł drzewa podiloczynów,
+ * @param remLength : wskaźnik na zapisanie długości reszty,
+ * @return reszta przydzielona funkcją malloc.
+ */
+static unsigned long *SubproductRemainder(const unsigned long *f, size_t length,
+                                          SubproductNode *node, size_t *remLength) {
+    size_t degree = node->end - node->begin;
+    *remLength = length < degree ? length : degree;
+    unsigned long *rem = SafeMalloc((length > 0 ? length : 1) * sizeof(unsigned long));
+    memcpy(rem, f, length * sizeof(unsigned long));
+    if (length <= degree) {
+        return rem;
+    }
+
+    size_t quotLength = length - degree;
+    if (degree < MULTIPOINT_NEWTON_THRESHOLD || quotLength < MULTIPOINT_NEWTON_THRESHOLD) {
+        for (size_t i = length; i-- > degree;) {
+            unsigned long c = rem[i];
+            for (size_t j = 0; j < degree; j++) {
+                rem[i - degree + j] = CoeffSub(rem[i - degree + j], CoeffMul(c, node->poly[j]));
+            }
+        }
+        return rem;
+    }
+
+    // Iloraz odwróconej dzielnej to jej iloczyn z odwrotnością odwróconego dzielnika.
+    ExtendInverse(node, quotLength);
+    unsigned long *reversed = SafeMalloc(quotLength * sizeof(unsigned long));
+    for (size_t i = 0; i < quotLength; i++) {
+        reversed[i] = f[length - 1 - i];
+    }
+    unsigned long *product = SafeMalloc((2 * quotLength - 1) * sizeof(unsigned long));
+    DenseMultiply(reversed, quotLength, node->inverse, quotLength, product);
+    for (size_t i = 0; i < quotLength; i++) {
+        reversed[i] = product[quotLength - 1 - i];
+    }
+    free(product);
+
+    product = SafeMalloc((quotLength + degree) * sizeof(unsigned long));
+    DenseMultiply(reversed, quotLength, node->poly, degree + 1, product);
+    for (size_t i = 0; i < degree; i++) {
+        rem[i] = CoeffSub(rem[i], product[i]);
+    }
+    free(product);
+    free(reversed);
+
+    return rem;
+}
+
+/**
+ * Liczy wartości wielomianu jednej zmiennej w punktach węzła drzewa podiloczynów, schodząc
+ * w drzewie z resztami z dzielenia przez iloczyny dzieci.
+ * @param node : węzeł drzewa podiloczynów,
+ * @param f : współczynniki wielomianu,
+ * @param length : liczba współczynników,
+ * @param points : punkty,
+ * @param values : tablica na wartości we wszystkich punktach drzewa.
+ */
+static void MultipointEvaluate(SubproductNode *node, const unsigned long *f, size_t length,
+                               const unsigned long *points, unsigned long *values) {
+    if (node->left == NULL) {
+        for (size_t j = node->begin; j < node->end; j++) {
+            unsigned long value = 0;
+            for (size_t i = length; i-- > 0;) {
+                value = CoeffAdd(CoeffMul(value, points[j]), f[i]);
+            }
+            values[j] = value;
+        }
+        return;
+    }
+
+    SubproductNode *children[] = {node->left, node->right};
+    for (size_t i = 0; i < 2; i++) {
+        size_t remLength;
+        unsigned long *rem = SubproductRemainder(f, length, children[i], &remLength);
+        MultipointEvaluate(children[i], rem, remLength, points, values);
+        free(rem);
+    }
+}
+
+/**
+ * Porównuje składniki spłaszczonego wielomianu po spakowanych wykładnikach.
+ * @param a : wskaźnik na pierwszy składnik,
+ * @param b : wskaźnik na drugi składnik,
+ * @return liczba ujemna, zero albo dodatnia, zależnie od kolejności składników.
+ */
+static int ComparePackedTerms(const void *a, const void *b) {
+    uint64_t x = ((const PackedTerm *)a)->exp, y = ((const PackedTerm *)b)->exp;
+    return (x > y) - (x < y);
+}
+
+void PolyAtMany(const Poly *p, size_t count, const poly_coeff_t xs[], Poly results[]) {
+    if (PolyIsCoeff(p)) {
+        for (size_t j = 0; j < count; j++) {
+            results[j] = PolyFromCoeff(p->coeff);
+        }
+        return;
+    }
+
+    // Wielomian jedynka nie zmienia podstaw pakowania, więc pakujemy sam wielomian p.
+    Poly one = PolyFromCoeff(1);
+    KroneckerPacking packing;
+    if (count < MULTIPOINT_MIN_POINTS ||
+        (size_t)MonoGetExp(&p->arr[p->size - 1]) + 1 < MULTIPOINT_MIN_LENGTH ||
+        !KroneckerPackingInit(p, &one, &packing)) {
+        for (size_t j = 0; j < count; j++) {
+            results[j] = PolyAt(p, xs[j]);
+        }
+        return;
+    }
+
+    // Kolumna to składniki o tych samych wykładnikach zmiennych innych niż x0. Wartość kolumny
+    // w punkcie jest współczynnikiem wyniku przy odpowiadającym jej jednomianie.
+    size_t termCount = 0;
+    PackedTerm *terms = SafeMalloc(PolyTermCount(p) * sizeof(PackedTerm));
+    PackTerms(p, 0, 0, &packing, terms, &termCount);
+    // Przestawiamy wykładnik x0 na najmniej znaczącą pozycję, więc po posortowaniu składniki
+    // kolumny leżą obok siebie, rosnąco po wykładniku x0.
+    uint64_t stride = packing.strides[0], base = packing.bases[0];
+    for (size_t i = 0; i < termCount; i++) {
+        terms[i].exp = terms[i].exp % stride * base + terms[i].exp / stride;
+    }
+    qsort(terms, termCount, sizeof(PackedTerm), ComparePackedTerms);
+
+    size_t columnCount = 0;
+    for (size_t i = 0; i < termCount; i++) {
+        columnCount += i == 0 || terms[i].exp / base != terms[i - 1].exp / base;
+    }
+    unsigned long *points = SafeMalloc(count * sizeof(unsigned long));
+    for (size_t j = 0; j < count; j++) {
+        points[j] = CoeffFromLong(xs[j]);
+    }
+    unsigned long *values = SafeMalloc(columnCount * count * sizeof(unsigned long));
+    uint64_t *columnKeys = SafeMalloc(columnCount * sizeof(uint64_t));
+    SubproductNode *tree = NULL;
+
+    for (size_t begin = 0, end, column = 0; begin < termCount; begin = end, column++) {
+        uint64_t key = terms[begin].exp / base;
+        for (end = begin + 1; end < termCount && terms[end].exp / base == key; end++) {
+        }
+        columnKeys[column] = key;
+        unsigned long *columnValues = values + column * count;
+
+        size_t length = (size_t)(terms[end - 1].exp % base) + 1;
+        if (length >= MULTIPOINT_MIN_LENGTH && 2 * (end - begin) >= length) {
+            if (tree == NULL) {
+                tree = BuildSubproductTree(points, 0, count);
+            }
+            unsigned long *f = SafeCalloc(length, sizeof(unsigned long));
+            for (size_t i = begin; i < end; i++) {
+                f[terms[i].exp % base] = (unsigned long)terms[i].coeff;
+            }
+            size_t remLength;
+            unsigned long *rem = SubproductRemainder(f, length, tree, &remLength);
+            MultipointEvaluate(tree, rem, remLength, points, columnValues);
+            free(rem);
+            free(f);
+        } else {
+            for (size_t j = 0; j < count; j++) {
+                unsigned long value = 0, power = CoeffFromLong(1);
+                uint64_t powerExp = 0;
+                for (size_t i = begin; i < end; i++) {
+                    uint64_t exp = terms[i].exp % base;
+                    power = CoeffMul(power, CoeffPow(points[j], exp - powerExp));
+                    powerExp = exp;
+                    value = CoeffAdd(value, CoeffMul(power, (unsigned long)terms[i].coeff));
+                }
+                columnValues[j] = value;
+            }
+        }
+    }
+
+    for (size_t j = 0; j < count; j++) {
+        size_t nonZero = 0;
+        for (size_t column = 0; column < columnCount; column++) {
+            unsigned long value = values[column * count + j];
+            if (value != 0) {
+                terms[nonZero++] = (PackedTerm){.exp = columnKeys[column],
+                                                .coeff = (poly_coeff_t)value};
+            }
+        }
+        results[j] = nonZero == 0 ? PolyZero() : UnpackTerms(terms, nonZero, 1, &packing);
+    }
+
+    if (tree != NULL) {
+        DestroySubproductTree(tree);
+    }
+    free(columnKeys);
+    free(values);
+    free(points);
+    free(terms);
+    KroneckerPackingDestroy(&packing);
+}
+
+/**
+ * Największy wykładnik, do którego PolyEval stablicowuje potęgi wartości jednej zmiennej.
+ * Wyższe potęgi są liczone szybkim potęgowaniem.
+ */
+#define EVAL_POWER_TABLE_MAX_EXP (1 << 12)
+
+/**
+ * Tablice potęg wartości zmiennych, współdzielone przez wszystkie węzły wielomianu.
+ */
+typedef struct {
+    size_t varCount;        ///< liczba zmiennych o stablicowanych potęgach
+    const poly_coeff_t *xs; ///< wartości zmiennych zredukowane do aktualnego pierścienia
+    poly_exp_t *maxExps;    ///< największy stablicowany wykładnik każdej zmiennej
+    poly_coeff_t **powers;  ///< potęgi: @f$powers[i][k] = x_i^k@f$
+} PowerTables;
+
+/**
+ * Zwraca potęgę wartości zmiennej, korzystając z tablicy potęg.
+ * @param tables : tablice potęg,
+ * @param var : indeks zmiennej,
+ * @param exp : wykładnik,
+ * @return @f$x_{var}^{exp}@f$.
+ */
+static inline poly_coeff_t PowerOf(const PowerTables *tables, size_t var, poly_exp_t exp) {
+    if (exp <= tables->maxExps[var]) {
+        return tables->powers[var][exp];
+    }
+    return RaiseToPower(tables->xs[var], exp);
+}
+
+/**
+ * Wylicza wartość wielomianu, którego pierwszą zmienną jest zmienna o indeksie @p var.
+ * Zmienne o indeksach spoza tablic potęg przyjmują wartość 0.
+ * @param p : wielomian,
+ * @param var : indeks pierwszej zmiennej wielomianu,
+ * @param tables : tablice potęg,
+ * @return wartość wielomianu.
+ */
+static poly_coeff_t EvalWithTables(const Poly *p, size_t var, const PowerTables *tables) {
+    if (PolyIsCoeff(p)) {
+        return p->coeff;
+    }
+    if (var >= tables->varCount) {
+        // Przy zerowej wartości zmiennej zostaje tylko jednomian z wykładnikiem 0.
+        return MonoGetExp(&p->arr[0]) == 0 ? EvalWithTables(&p->arr[0].p, var + 1, tables) : 0;
+    }
+
+    poly_coeff_t sum = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        poly_coeff_t value = EvalWithTables(&p->arr[i].p, var + 1, tables);
+        sum = AddCoeffs(sum, MulCoeffs(PowerOf(tables, var, MonoGetExp(&p->arr[i])), value));
+    }
+    return sum;
+}
+
+poly_coeff_t PolyEval(const Poly *p, const poly_coeff_t *xs, size_t varCount) {
+    if (PolyIsCoeff(p)) {
+        return p->coeff;
+    }
+
+    const PolyDegrees *cached = CachedDegrees(p);
+    PolyDegrees *computed = cached == NULL ? ComputeDegrees(p) : NULL;
+    const PolyDegrees *degrees = cached != NULL ? cached : computed;
+
+    PowerTables tables = {.varCount = varCount < degrees->varCount ? varCount : degrees->varCount};
+    poly_coeff_t *reduced = SafeMalloc((tables.varCount + 1) * sizeof(poly_coeff_t));
+    tables.maxExps = SafeMalloc((tables.varCount + 1) * sizeof(poly_exp_t));
+    tables.powers = SafeMalloc((tables.varCount + 1) * sizeof(poly_coeff_t *));
+    for (size_t var = 0; var < tables.varCount; var++) {
+        poly_exp_t maxExp = degrees->degBy[var] < EVAL_POWER_TABLE_MAX_EXP
+                                ? degrees->degBy[var]
+                                : EVAL_POWER_TABLE_MAX_EXP;
+        reduced[var] = (poly_coeff_t)CoeffFromLong(xs[var]);
+        tables.maxExps[var] = maxExp;
+        tables.powers[var] = SafeMalloc(((size_t)maxExp + 1) * sizeof(poly_coeff_t));
+        tables.powers[var][0] = 1;
+        for (poly_exp_t exp = 1; exp <= maxExp; exp++) {
+            tables.powers[var][exp] = MulCoeffs(tables.powers[var][exp - 1], reduced[var]);
+        }
+    }
+    tables.xs = reduced;
+    free(computed);
+
+    poly_coeff_t result = EvalWithTables(p, 0, &tables);
+
+    for (size_t var = 0; var < tables.varCount; var++) {
+        free(tables.powers[var]);
+    }
+    free(tables.powers);
+    free(tables.maxExps);
+    free(reduced);
+
+    return result;
+}
+
+/**
+ * Liczba punktów, w których PolyEvalBatch liczy wartości jednego węzła naraz.
+ */
+#define EVAL_BATCH_BLOCK_SIZE 256
+
+/**
+ * Największy wykładnik, do którego PolyEvalBatch stablicowuje dla każdego bloku potęgi wartości
+ * jednej zmiennej. Wyższe potęgi są liczone z poprzednich szybkim potęgowaniem.
+ */
+#define EVAL_BATCH_POWER_TABLE_MAX_EXP 32
+
+/**
+ * Zadanie wyliczające wartości wielomianu w kolejnych blokach punktów. Wartości zmiennych są
+ * przechowywane kolumnami (jedna tablica na zmienną), więc pętle po punktach bloku przechodzą
+ * pamięć po kolei.
+ */
+typedef struct {
+    const Poly *p;                 ///< wielomian
+    const poly_coeff_t *const *xs; ///< wartości zmiennych: @f$xs[i][k]@f$ dla punktu @f$k@f$
+    size_t varCount;               ///< liczba zmiennych o podanych wartościach
+    const poly_exp_t *maxExps;     ///< największy stablicowany wykładnik każdej zmiennej
+    size_t begin;                  ///< pierwszy punkt zadania
+    size_t end;                    ///< punkt za ostatnim punktem zadania
+    poly_coeff_t *results;         ///< tablica wyników wszystkich punktów
+    poly_coeff_t **levels;         ///< bufory zmiennych: wartość, potęga, wynik, tablica potęg
+    size_t blockSize;              ///< liczba punktów aktualnego bloku
+} EvalBatchTask;
+
+/**
+ * Zwraca wiersz bufora zmiennej. Wiersz 0 to wartości zmiennej w punktach bloku, wiersz 1
+ * to potęgi spoza tablicy, wiersz 2 to wartości współczynników, a wiersz @f$3 + e@f$ to
+ * @f$e@f$-te potęgi wartości zmiennej.
+ * @param task : zadanie,
+ * @param var : indeks zmiennej,
+ * @param row : numer wiersza,
+ * @return wiersz długości EVAL_BATCH_BLOCK_SIZE.
+ */
+static inline poly_coeff_t *EvalRow(const EvalBatchTask *task, size_t var, size_t row) {
+    return task->levels[var] + row * EVAL_BATCH_BLOCK_SIZE;
+}
+
+/**
+ * Wylicza wartości wielomianu, którego pierwszą zmienną jest zmienna o indeksie @p var,
+ * w punktach aktualnego bloku. Zmienne o indeksach spoza zadania przyjmują wartość 0.
+ * @param p : wielomian,
+ * @param var : indeks pierwszej zmiennej wielomianu,
+ * @param task : zadanie z wartościami zmiennych bloku w buforach,
+ * @param out : tablica na wartości w punktach bloku.
+ */
+static void EvalBlock(const Poly *p, size_t var, const EvalBatchTask *task, poly_coeff_t *out) {
+    size_t n = task->blockSize;
+    if (PolyIsCoeff(p)) {
+        for (size_t k = 0; k < n; k++) {
+            out[k] = p->coeff;
+        }
+        return;
+    }
+    if (var >= task->varCount) {
+        if (MonoGetExp(&p->arr[0]) == 0) {
+            EvalBlock(&p->arr[0].p, var + 1, task, out);
+        } else {
+            memset(out, 0, n * sizeof(poly_coeff_t));
+        }
+        return;
+    }
+
+    const poly_coeff_t *x = EvalRow(task, var, 0);
+    poly_coeff_t *power = EvalRow(task, var, 1);
+    poly_coeff_t *value = EvalRow(task, var, 2);
+    poly_exp_t maxExp = task->maxExps[var];
+    memset(out, 0, n * sizeof(poly_coeff_t));
+
+    poly_exp_t powerExp = -1; // Wykładnik potęgi w wierszu power, -1 przed pierwszym użyciem.
+    for (size_t i = 0; i < p->size; i++) {
+        poly_exp_t exp = MonoGetExp(&p->arr[i]);
+        const poly_coeff_t *row;
+        if (exp <= maxExp) {
+            row = EvalRow(task, var, 3 + (size_t)exp);
+        } else {
+            if (powerExp < maxExp) {
+                memcpy(power, EvalRow(task, var, 3 + (size_t)maxExp), n * sizeof(poly_coeff_t));
+                powerExp = maxExp;
+            }
+            for (size_t k = 0; k < n; k++) {
+                power[k] = MulCoeffs(power[k], RaiseToPower(x[k], exp - powerExp));
+            }
+            powerExp = exp;
+            row = power;
+        }
+
+        const Poly *coeff = &p->arr[i].p;
+        if (PolyIsCoeff(coeff)) {
+            for (size_t k = 0; k < n; k++) {
+                out[k] = AddCoeffs(out[k], MulCoeffs(row[k], coeff->coeff));
+            }
+        } else {
+            EvalBlock(coeff, var + 1, task, value);
+            for (size_t k = 0; k < n; k++) {
+                out[k] = AddCoeffs(out[k], MulCoeffs(row[k], value[k]));
+            }
+        }
+    }
+}
+
+/**
+ * Wykonuje zadanie wyliczania wartości w blokach punktów.
+ * @param arg : wskaźnik na EvalBatchTask.
+ */
+static void RunEvalBatchTask(void *arg) {
+    EvalBatchTask *task = arg;
+    size_t rowCount = 0;
+    for (size_t var = 0; var < task->varCount; var++) {
+        rowCount += 4 + (size_t)task->maxExps[var];
+    }
+    poly_coeff_t *scratch = SafeMalloc((rowCount + 1) * EVAL_BATCH_BLOCK_SIZE *
+                                       sizeof(poly_coeff_t));
+    task->levels = SafeMalloc((task->varCount + 1) * sizeof(poly_coeff_t *));
+    for (size_t var = 0, offset = 0; var < task->varCount; var++) {
+        task->levels[var] = scratch + offset;
+        offset += (4 + (size_t)task->maxExps[var]) * EVAL_BATCH_BLOCK_SIZE;
+    }
+
+    for (size_t begin = task->begin; begin < task->end; begin += EVAL_BATCH_BLOCK_SIZE) {
+        size_t n = task->end - begin < EVAL_BATCH_BLOCK_SIZE ? task->end - begin
+                                                              : EVAL_BATCH_BLOCK_SIZE;
+        task->blockSize = n;
+        for (size_t var = 0; var < task->varCount; var++) {
+            poly_coeff_t *x = EvalRow(task, var, 0);
+            for (size_t k = 0; k < n; k++) {
+                x[k] = (poly_coeff_t)CoeffFromLong(task->xs[var][begin + k]);
+            }
+            poly_coeff_t *row = EvalRow(task, var, 3);
+            for (size_t k = 0; k < n; k++) {
+                row[k] = 1;
+            }
+            for (poly_exp_t exp = 1; exp <= task->maxExps[var]; exp++) {
+                poly_coeff_t *next = row + EVAL_BATCH_BLOCK_SIZE;
+                for (size_t k = 0; k < n; k++) {
+                    next[k] = MulCoeffs(row[k], x[k]);
+                }
+                row = next;
+            }
+        }
+        EvalBlock(task->p, 0, task, task->results + begin);
+    }
+
+    free(task->levels);
+    free(scratch);
+}
+
+void PolyEvalBatch(const Poly *p, const poly_coeff_t *const xs[], size_t varCount,
+                   size_t pointCount, poly_coeff_t results[]) {
+    if (PolyIsCoeff(p)) {
+        for (size_t k = 0; k < pointCount; k++) {
+            results[k] = p->coeff;
+        }
+        return;
+    }
+
+    const PolyDegrees *cached = CachedDegrees(p);
+    PolyDegrees *computed = cached == NULL ? ComputeDegrees(p) : NULL;
+    const PolyDegrees *degrees = cached != NULL ? cached : computed;
+    if (degrees->varCount < varCount) {
+        varCount = degrees->varCount;
+    }
+    poly_exp_t *maxExps = SafeMalloc((varCount + 1) * sizeof(poly_exp_t));
+    for (size_t var = 0; var < varCount; var++) {
+        maxExps[var] = degrees->degBy[var] < EVAL_BATCH_POWER_TABLE_MAX_EXP
+                           ? degrees->degBy[var]
+                           : EVAL_BATCH_POWER_TABLE_MAX_EXP;
+    }
+    free(computed);
+
+    // Każde zadanie dostaje ciągły zakres pełnych bloków i własne bufory.
+    size_t blockCount = (pointCount + EVAL_BATCH_BLOCK_SIZE - 1) / EVAL_BATCH_BLOCK_SIZE;
+    size_t taskCount = IsParallel() ? 4 * ThreadPoolThreadCount() : 1;
+    if (taskCount > blockCount) {
+        taskCount = blockCount > 0 ? blockCount : 1;
+    }
+
+    EvalBatchTask *tasks = SafeMalloc(taskCount * sizeof(EvalBatchTask));
+    TaskGroup group = {.pending = 0};
+    for (size_t i = 0; i < taskCount; i++) {
+        size_t begin = blockCount * i / taskCount * EVAL_BATCH_BLOCK_SIZE;
+        size_t end = blockCount * (i + 1) / taskCount * EVAL_BATCH_BLOCK_SIZE;
+        tasks[i] = (EvalBatchTask){.p = p, .xs = xs, .varCount = varCount, .maxExps = maxExps,
+                                   .begin = begin, .end = end < pointCount ? end : pointCount,
+                                   .results = results};
+        if (taskCount > 1) {
+            ThreadPoolSpawn(&group, RunEvalBatchTask, &tasks[i]);
+        } else {
+            RunEvalBatchTask(&tasks[i]);
+        }
+    }
+    ThreadPoolWait(&group);
+    free(tasks);
+    free(maxExps);
+}
+
+bool PolySetModulus(poly_coeff_t modulus) {
+    return modulus >= 0 && CoeffRingSetModulus((unsigned long)modulus);
+}
+
+poly_coeff_t PolyGetModulus(void) {
+    return (poly_coeff_t)coeffRing.modulus;
+}
+
+Poly PolyReduceMove(Poly *p) {
+    Poly result = *p;
+    *p = PolyZero();
+
+    if (PolyIsCoeff(&result)) {
+        return PolyFromCoeff((poly_coeff_t)CoeffFromLong(result.coeff));
+    }
+
+    Unshare(&result);
+    size_t count = 0;
+    for (size_t i = 0; i < result.size; i++) {
+        Poly coeff = PolyReduceMove(&result.arr[i].p);
+        if (!PolyIsZero(&coeff)) {
+            result.arr[count++] = MonoFromPoly(&coeff, MonoGetExp(&result.arr[i]));
+        }
+    }
+
+    return PolyFromSortedMonos(count, result.size, result.arr);
+}
+
+void PolySetThreadCount(size_t count) {
+    ThreadPoolSetThreadCount(count);
+}
+
+/**
+ * Początkowy rozmiar areny tymczasowej w bajtach.
+ */
+#define SCRATCH_ARENA_SIZE (1 << 20)
+
+/**
+ * Arena tymczasowa bieżącego wątku, używana między PolyArenaBegin i PolyArenaEnd.
+ */
+static _Thread_local Arena *scratchArena = NULL;
+
+void PolyArenaBegin(void) {
+    if (scratchArena == NULL) {
+        scratchArena = ArenaCreate(SCRATCH_ARENA_SIZE);
+    }
+    MonoArraySetArena(scratchArena);
+}
+
+void PolyArenaEnd(void) {
+    MonoArraySetArena(NULL);
+    if (scratchArena != NULL) {
+        ArenaReset(scratchArena);
+    }
+}
+
+/**
+ * Liczy, ile bajtów areny zajmą tablice jednomianów kopii wielomianu.
+ * @param p : wielomian,
+ * @return rozmiar regionu potrzebnego na kopię @p p.
+ */
+static size_t RegionSize(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return 0;
+    }
+
+    size_t size = MonoArrayAllocationSize(p->size);
+    for (size_t i = 0; i < p->size; i++) {
+        size += RegionSize(&p->arr[i].p);
+    }
+    return size;
+}
+
+/**
+ * Kopiuje całe drzewo wielomianu, także jego współdzielone węzły.
+ * @param p : wielomian,
+ * @return kopia @p p bez współdzielonych węzłów.
+ */
+static Poly CopyTree(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return *p;
+    }
+
+    Poly copy = {.size = p->size, .arr = SafeMonoArrayAlloc(p->size)};
+    for (size_t i = 0; i < p->size; i++) {
+        copy.arr[i] = (Mono){.exp = p->arr[i].exp, .p = CopyTree(&p->arr[i].p)};
+    }
+    return copy;
+}
+
+/**
+ * Kopiuje wielomian niebędący współczynnikiem do nowego regionu.
+ * @param p : wielomian,
+ * @return kopia @p p w nowym regionie.
+ */
+static Poly CopyToRegion(const Poly *p) {
+    Arena *previous = MonoArraySetArena(ArenaCreate(RegionSize(p)));
+    Poly copy = CopyTree(p);
+    MonoArraySetArena(previous);
+    MonoArrayMarkRegionRoot(copy.arr);
+
+    return copy;
+}
+
+Poly PolyMoveToRegion(Poly *p) {
+    Poly result = *p;
+    *p = PolyZero();
+    if (PolyIsCoeff(&result) || MonoArrayIsRegionRoot(result.arr)) {
+        return result;
+    }
+
+    Poly copy = CopyToRegion(&result);
+    PolyDestroy(&result);
+    return copy;
+}
+
+/**
+ * Zamienia drzewo wielomianu na współdzielone węzły, nie zmieniając argumentu.
+ * @param p : wielomian,
+ * @return nowe odwołanie do współdzielonego wielomianu równego @p p.
+ */
+static Poly InternTree(const Poly *p) {
+    if (PolyIsCoeff(p) || MonoArrayIsInterned(p->arr)) {
+        return PolyClone(p);
+    }
+
+    Mono *monos = SafeMonoArrayAllocShared(p->size);
+    for (size_t i = 0; i < p->size; i++) {
+        monos[i] = (Mono){.exp = p->arr[i].exp, .p = InternTree(&p->arr[i].p)};
+    }
+
+    Poly result = {.size = p->size, .arr = InternTableInsert(p->size, monos)};
+    if (result.arr != monos) { // Taki węzeł już istniał.
+        Poly duplicate = {.size = p->size, .arr = monos};
+        PolyDestroy(&duplicate);
+    }
+    return result;
+}
+
+Poly PolyIntern(Poly *p) {
+    Poly result = InternTree(p);
+
+    PolyDestroy(p);
+    *p = PolyZero();
+    return result;
 }
@@ -179,12 +179,59 @@ Poly PolyNeg(const Poly *p);
  */
 Poly PolySub(const Poly *p, const Poly *q);
 
+/**
+ * Dodaje dwa wielomiany, przejmując na własność zawartość struktur
+ * wskazywanych przez @p p i @p q. Tablice jednomianów argumentów są
+ * wykorzystywane ponownie w wyniku. Po wywołaniu @p p i @p q są wielomianami
+ * zerowymi.
+ * @param p : wielomian @f$p@f$
+ * @param q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+Poly PolyAddMove(Poly *p, Poly *q);
+
+/**
+ * Odejmuje wielomian od wielomianu, przejmując na własność zawartość struktur
+ * wskazywanych przez @p p i @p q. Po wywołaniu @p p i @p q są wielomianami
+ * zerowymi.
+ * @param p : wielomian @f$p@f$
+ * @param q : wielomian @f$q@f$
+ * @return @f$p - q@f$
+ */
+Poly PolySubMove(Poly *p, Poly *q);
+
+/**
+ * Mnoży dwa wielomiany, przejmując na własność zawartość struktur
+ * wskazywanych przez @p p i @p q. Po wywołaniu @p p i @p q są wielomianami
+ * zerowymi.
+ * @param p : wielomian @f$p@f$
+ * @param q : wielomian @f$q@f$
+ * @return @f$p \cdot q@f$
+ */
+Poly PolyMulMove(Poly *p, Poly *q);
+
+/**
+ * Zwraca przeciwny wielomian, zamieniając znaki współczynników w miejscu.
+ * Przejmuje na własność zawartość struktury wskazywanej przez @p p.
+ * Po wywołaniu @p p jest wielomianem zerowym.
+ * @param p : wielomian @f$p@f$
+ * @return @f$-p@f$
+ */
+Poly PolyNegMove(Poly *p);
+
 /**
  * Zwraca stopień wielomianu ze względu na zadaną zmienną (-1 dla wielomianu
  * tożsamościowo równego zeru). Zmienne indeksowane są od 0.
  * Zmienna o indeksie 0 oznacza zmienną główną tego wielomianu.
  * Większe indeksy oznaczają zmienne wielomianów znajdujących się
  * we współczynnikach.
+ * Stopnie węzła są liczone leniwie i zapamiętywane w nim, więc pierwsze
+ * wywołanie dla nowego wielomianu przechodzi całe jego drzewo i przydziela
+ * podsumowanie stopni dla każdego węzła niestałego; kolejne wywołania
+ * działają w czasie stałym. Tablice z areny (opcja -a) nie zapamiętują
+ * stopni, więc dla nich każde wywołanie przechodzi drzewo do głębokości
+ * zmiennej. Stopień względem zmiennej o indeksie 0 jest zawsze liczony
+ * w czasie stałym.
  * @param p : wielomian
  * @param varIndex : indeks zmiennej
  * @return stopień wielomianu @p p z względu na zmienną o indeksie @p varIndex
@@ -193,19 +240,34 @@ poly_exp_t PolyDegBy(const Poly *p, size_t varIndex);
 
 /**
  * Zwraca stopień wielomianu (-1 dla wielomianu tożsamościowo równego zeru).
+ * Tak jak w PolyDegBy, pierwsze wywołanie dla nowego wielomianu przechodzi
+ * całe drzewo i zapamiętuje podsumowanie stopni w każdym węźle niestałym,
+ * a kolejne działają w czasie stałym. Dla tablic z areny (opcja -a)
+ * każde wywołanie przechodzi całe drzewo.
  * @param p : wielomian
  * @return stopień wielomianu @p p
  */
 poly_exp_t PolyDeg(const Poly *p);
 
 /**
- * Sprawdza równość dwóch wielomianów.
+ * Sprawdza równość dwóch wielomianów. Wielomiany o różnych skrótach (patrz
+ * PolyHash) są odrzucane bez przechodzenia drzew.
  * @param p : wielomian @f$p@f$
  * @param q : wielomian @f$q@f$
  * @return @f$p = q@f$
  */
 bool PolyIsEq(const Poly *p, const Poly *q);
 
+/**
+ * Zwraca skrót strukturalny wielomianu: równe wielomiany mają równe skróty.
+ * Skrót wielomianu niestałego jest liczony przy pierwszym wywołaniu
+ * i zapamiętywany w każdym węźle drzewa, więc kolejne wywołania działają
+ * w czasie stałym, dopóki wielomian nie zostanie zmieniony.
+ * @param p : wielomian @f$p@f$
+ * @return skrót @f$p@f$
+ */
+size_t PolyHash(const Poly *p);
+
 /**
  * Wylicza wartość wielomianu w punkcie @p x.
  * Wstawia pod pierwszą zmienną wielomianu wartość @p x.
@@ -219,8 +281,128 @@ bool PolyIsEq(const Poly *p, const Poly *q);
  */
 Poly PolyAt(const Poly *p, poly_coeff_t x);
 
+/**
+ * Wylicza wartości wielomianu w wielu punktach naraz (patrz PolyAt).
+ * Jeśli wielomian ma wysoki stopień względem pierwszej zmiennej, a punktów
+ * jest dużo, gęste części wielomianu są wyliczane we wszystkich punktach
+ * naraz szybką ewaluacją wielopunktową (drzewem podiloczynów).
+ * @param p : wielomian @f$p@f$
+ * @param count : liczba punktów
+ * @param xs : wartości argumentu @f$x@f$
+ * @param results : tablica długości @p count na wielomiany
+ * @f$p(x, x_0, x_1, \ldots)@f$ dla kolejnych wartości @f$x@f$
+ */
+void PolyAtMany(const Poly *p, size_t count, const poly_coeff_t xs[], Poly results[]);
+
+/**
+ * Wylicza wartość liczbową wielomianu, wstawiając pod wszystkie zmienne
+ * podane wartości. Nie tworzy wielomianów pośrednich: potęgi wartości każdej
+ * zmiennej są liczone raz i współdzielone przez cały wielomian.
+ * Zmienne o indeksach nie mniejszych niż @p varCount przyjmują wartość 0.
+ * @param p : wielomian @f$p@f$
+ * @param xs : wartości zmiennych @f$x_0, x_1, \ldots@f$
+ * @param varCount : liczba wartości w tablicy @p xs
+ * @return @f$p(x_0, x_1, \ldots)@f$
+ */
+poly_coeff_t PolyEval(const Poly *p, const poly_coeff_t *xs, size_t varCount);
+
+/**
+ * Wylicza wartości liczbowe wielomianu w wielu punktach naraz (patrz PolyEval).
+ * Wielomian jest przechodzony raz na blok punktów, a w każdym węźle wartości
+ * są liczone dla całego bloku. Wartości zmiennych są podawane kolumnami:
+ * @f$xs[i][k]@f$ to wartość zmiennej @f$x_i@f$ w punkcie @f$k@f$.
+ * Zmienne o indeksach nie mniejszych niż @p varCount przyjmują wartość 0.
+ * @param p : wielomian @f$p@f$
+ * @param xs : tablica @p varCount kolumn wartości zmiennych, każda długości @p pointCount
+ * @param varCount : liczba kolumn w tablicy @p xs
+ * @param pointCount : liczba punktów
+ * @param results : tablica długości @p pointCount na wartości @f$p@f$ w kolejnych punktach
+ */
+void PolyEvalBatch(const Poly *p, const poly_coeff_t *const xs[], size_t varCount,
+                   size_t pointCount, poly_coeff_t results[]);
+
+/**
+ * Ustawia moduł arytmetyki współczynników. Po ustawieniu liczby pierwszej
+ * @f$p@f$ wszystkie działania na wielomianach liczą współczynniki modulo
+ * @f$p@f$, a wyniki mają współczynniki z przedziału @f$[0, p)@f$. Argumenty
+ * działań muszą mieć wtedy współczynniki z tego przedziału (patrz
+ * PolyReduceMove). Moduł 0 przywraca arytmetykę na typie long.
+ * @param modulus : liczba pierwsza mniejsza niż @f$2^{62}@f$ albo 0
+ * @return false, jeśli moduł jest niepoprawny; wtedy tryb się nie zmienia
+ */
+bool PolySetModulus(poly_coeff_t modulus);
+
+/**
+ * Zwraca aktualny moduł arytmetyki współczynników.
+ * @return moduł albo 0, jeśli współczynniki nie są liczone modulo
+ */
+poly_coeff_t PolyGetModulus(void);
+
+/**
+ * Redukuje współczynniki wielomianu modulo aktualny moduł.
+ * Przejmuje na własność zawartość struktury wskazywanej przez @p p.
+ * Po wywołaniu @p p jest wielomianem zerowym.
+ * @param p : wielomian @f$p@f$
+ * @return @f$p@f$ ze współczynnikami z przedziału @f$[0, p)@f$
+ */
+Poly PolyReduceMove(Poly *p);
+
+/**
+ * Ustawia liczbę wątków używanych przy mnożeniu dużych wielomianów, licząc
+ * wątek wywołujący. Nie może być wywoływana w trakcie innych działań na
+ * wielomianach.
+ * @param count : liczba wątków; 0 i 1 oznaczają obliczenia sekwencyjne
+ */
+void PolySetThreadCount(size_t count);
+
+/**
+ * Rozpoczyna w bieżącym wątku obliczenia w arenie tymczasowej: od tej chwili
+ * nowe tablice jednomianów są przydzielane w niej przez przesunięcie
+ * wskaźnika, a ich zwalnianie nic nie kosztuje. Wielomiany utworzone w arenie
+ * są ważne do wywołania PolyArenaEnd; wynik, który ma przetrwać, należy
+ * przenieść do własnego regionu funkcją PolyMoveToRegion.
+ */
+void PolyArenaBegin(void);
+
+/**
+ * Kończy obliczenia w arenie tymczasowej bieżącego wątku i odzyskuje całą jej
+ * pamięć naraz. Nowe tablice jednomianów są znów przydzielane funkcją malloc.
+ */
+void PolyArenaEnd(void);
+
+/**
+ * Przenosi wielomian do własnego regionu - areny mieszczącej dokładnie jego
+ * drzewo. Usunięcie wyniku funkcją PolyDestroy zwalnia cały region jednym
+ * wywołaniem free. Wielomian w regionie można przekazywać do wszystkich
+ * funkcji; PolyAddMove i PolySubMove przejmują wtedy region większego
+ * składnika i budują w nim sumę, więc jej wynik jest już w regionie.
+ * Przejmuje na własność zawartość struktury wskazywanej przez @p p.
+ * Po wywołaniu @p p jest wielomianem zerowym.
+ * @param p : wielomian @f$p@f$
+ * @return @f$p@f$ w nowym regionie
+ */
+Poly PolyMoveToRegion(Poly *p);
+
+/**
+ * Zamienia drzewo wielomianu na współdzielone węzły z licznikami odwołań.
+ * Strukturalnie równe poddrzewa wszystkich współdzielonych wielomianów są
+ * przechowywane raz, PolyClone współdzielonego wielomianu tylko zwiększa
+ * licznik odwołań, a PolyIsEq porównuje współdzielone węzły po adresach.
+ * Współdzielony wielomian można przekazywać do wszystkich funkcji; funkcje
+ * przejmujące argumenty na własność kopiują płytko każdy węzeł, który
+ * modyfikują. Przejmuje na własność zawartość struktury wskazywanej przez
+ * @p p. Po wywołaniu @p p jest wielomianem zerowym.
+ * @param p : wielomian @f$p@f$
+ * @return współdzielony wielomian równy @f$p@f$
+ */
+Poly PolyIntern(Poly *p);
+
 /**
  * Rekurencyjnie i głęboko sprawdza czy jednomian jest zerowy.
+ * Wszystkie funkcje biblioteki zwracają wielomiany w postaci kanonicznej (bez
+ * jednomianów zerowych i bez jednomianów @f$(c, 0)@f$ jako jedynych w węźle),
+ * więc dla nich wystarcza płytkie PolyIsZero; ta funkcja służy do wielomianów
+ * zbudowanych ręcznie.
  * @param m : jednomian @f$m@f$.
  * @return @f$m = 0@f$.
  */
@@ -228,7 +410,8 @@ bool RecursiveMonoIsZero(const Mono *m);
 
 /**
  * Rekurencyjnie i głęboko sprawdza czy wielomian jest współczynnikiem i ustawia
- * jego wartość na podaną w argumentach zmienną.
+ * jego wartość na podaną w argumentach zmienną. Dla wielomianów w postaci
+ * kanonicznej wystarcza płytkie PolyIsCoeff (patrz RecursiveMonoIsZero).
  * @param p : wielomian @f$p@f$.,
  * @param *result : wskaźnik na zmienną, na której zapisujemy wartość
  * współczynnika,
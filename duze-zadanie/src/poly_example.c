@@ -2,7 +2,9 @@
 #undef NDEBUG
 #endif
 
+#include "packed_poly.h"
 #include "poly.h"
+#include "poly_tape.h"
 #include <assert.h>
 #include <stdbool.h>
 #include <stdarg.h>
@@ -300,6 +302,35 @@ static bool SimpleAtTest(void) {
     return res;
 }
 
+static bool TestMoveOp(Poly a, Poly b, Poly (*op)(const Poly *, const Poly *),
+                       Poly (*moveOp)(Poly *, Poly *)) {
+    Poly expected = op(&a, &b);
+    Poly c = moveOp(&a, &b);
+    bool is_eq = PolyIsEq(&c, &expected) && PolyIsZero(&a) && PolyIsZero(&b);
+    PolyDestroy(&c);
+    PolyDestroy(&expected);
+    return is_eq;
+}
+
+static bool SimpleMoveTest(void) {
+    bool res = true;
+    res &= TestMoveOp(P(C(1), 1, C(2), 2), P(C(-1), 1), PolyAdd, PolyAddMove);
+    res &= TestMoveOp(C(1), P(C(-1), 0, C(1), 1), PolyAdd, PolyAddMove);
+    res &= TestMoveOp(P(P(C(1), 0, C(1), 1), 0, C(1), 1),
+                      P(P(C(1), 0, C(-1), 1), 0, C(-1), 1), PolyAdd, PolyAddMove);
+    res &= TestMoveOp(POLY_P, P(C(2), 0, C(1), 4), PolySub, PolySubMove);
+    res &= TestMoveOp(POLY_P, POLY_P, PolySub, PolySubMove);
+    res &= TestMoveOp(P(C(1L << 32), 0, C(1), 1), C(1L << 32), PolyMul, PolyMulMove);
+    res &= TestMoveOp(POLY_P, P(C(-1), 0, C(1), 1), PolyMul, PolyMulMove);
+    Poly a = POLY_P;
+    Poly b = PolyNeg(&a);
+    Poly c = PolyNegMove(&a);
+    res &= PolyIsEq(&b, &c) && PolyIsZero(&a);
+    PolyDestroy(&b);
+    PolyDestroy(&c);
+    return res;
+}
+
 static bool OverflowTest(void) {
     bool res = true;
     res &= TestMul(P(C(1L << 32), 1), C(1L << 32), C(0));
@@ -309,6 +340,132 @@ static bool OverflowTest(void) {
     return res;
 }
 
+static bool TestPackedRoundTrip(Poly a, size_t varCount) {
+    PackedPoly packed;
+    bool is_eq = PackedPolyFromPoly(&a, varCount, &packed);
+    if (is_eq) {
+        Poly b = PackedPolyToPoly(&packed);
+        is_eq = PolyIsEq(&a, &b);
+        PolyDestroy(&b);
+        PackedPolyDestroy(&packed);
+    }
+    PolyDestroy(&a);
+    return is_eq;
+}
+
+static bool TestPackedFails(Poly a, size_t varCount) {
+    PackedPoly packed;
+    bool fails = !PackedPolyFromPoly(&a, varCount, &packed);
+    PolyDestroy(&a);
+    return fails;
+}
+
+static bool TestPackedOp(Poly a, Poly b, size_t varCount,
+                         Poly (*op)(const Poly *, const Poly *)) {
+    PackedPoly pa = {0}, pb = {0}, pc;
+    bool is_eq = PackedPolyFromPoly(&a, varCount, &pa) && PackedPolyFromPoly(&b, varCount, &pb);
+    if (is_eq) {
+        if (op == PolyAdd) {
+            pc = PackedPolyAdd(&pa, &pb);
+        } else {
+            is_eq = PackedPolyMul(&pa, &pb, &pc);
+        }
+    }
+    if (is_eq) {
+        Poly expected = op(&a, &b);
+        Poly c = PackedPolyToPoly(&pc);
+        is_eq = PolyIsEq(&c, &expected);
+        PolyDestroy(&c);
+        PolyDestroy(&expected);
+        PackedPolyDestroy(&pc);
+    }
+    PackedPolyDestroy(&pa);
+    PackedPolyDestroy(&pb);
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+    return is_eq;
+}
+
+static bool TestPackedEval(Poly a, size_t varCount, const poly_coeff_t *xs, size_t count) {
+    PackedPoly packed;
+    bool is_eq = PackedPolyFromPoly(&a, varCount, &packed);
+    if (is_eq) {
+        is_eq = PackedPolyEval(&packed, xs, count) == PolyEval(&a, xs, count);
+        PackedPolyDestroy(&packed);
+    }
+    PolyDestroy(&a);
+    return is_eq;
+}
+
+static bool PackedTest(void) {
+    bool res = true;
+    res &= TestPackedRoundTrip(C(0), 1);
+    res &= TestPackedRoundTrip(C(5), 1);
+    res &= TestPackedRoundTrip(P(C(1), 0, C(-2), 7), 1);
+    res &= TestPackedRoundTrip(POLY_P, 2);
+    res &= TestPackedRoundTrip(POLY_P, 4);
+    res &= TestPackedRoundTrip(P(P(P(C(3), 2), 0, C(1), 1), 5, C(2), 6), 3);
+    res &= TestPackedRoundTrip(P(P(C(1), 1), 0), 2);
+    // Za mało zmiennych albo wykładnik zajmujący bit strażniczy pola.
+    res &= TestPackedFails(POLY_P, 1);
+    res &= TestPackedFails(P(C(1), 1 << 15), 4);
+    res &= TestPackedRoundTrip(P(C(1), (1 << 15) - 1), 4);
+    res &= TestPackedFails(P(C(1), 1), 64);
+
+    res &= TestPackedOp(POLY_P, P(P(C(-1), 3), 0, C(1), 1), 2, PolyAdd);
+    res &= TestPackedOp(POLY_P, POLY_P, 3, PolyAdd);
+    res &= TestPackedOp(P(C(1), 0, C(1), 1), P(C(-1), 0, C(1), 1), 1, PolyAdd);
+    res &= TestPackedOp(POLY_P, P(P(C(-1), 3), 0, C(1), 1), 2, PolyMul);
+    res &= TestPackedOp(P(C(1), 0, C(1), 1), P(C(-1), 0, C(1), 1), 1, PolyMul);
+    res &= TestPackedOp(P(C(1L << 32), 1), C(1L << 32), 1, PolyMul);
+    res &= TestPackedOp(C(0), POLY_P, 2, PolyMul);
+    // Wykładnik iloczynu nie mieści się w 16-bitowym polu.
+    res &= !TestPackedOp(P(C(1), 1 << 14), P(C(1), 1 << 14), 4, PolyMul);
+
+    const poly_coeff_t xs[] = {2, -3, 5};
+    res &= TestPackedEval(POLY_P, 2, xs, 2);
+    res &= TestPackedEval(POLY_P, 3, xs, 1);
+    res &= TestPackedEval(P(P(P(C(3), 2), 0, C(1), 1), 5, C(2), 6), 3, xs, 3);
+    res &= TestPackedEval(P(C(1), 64), 1, xs, 1);
+    return res;
+}
+
+static bool TestEval(Poly a, const poly_coeff_t *xs, size_t count, poly_coeff_t res) {
+    PolyTape *tape = PolyCompile(&a);
+    bool is_eq = PolyEval(&a, xs, count) == res && PolyTapeEval(tape, xs, count) == res;
+    PolyTapeDestroy(tape);
+    PolyDestroy(&a);
+    return is_eq;
+}
+
+static bool TestEvalMatchesTape(Poly a, const poly_coeff_t *xs, size_t count) {
+    PolyTape *tape = PolyCompile(&a);
+    bool is_eq = PolyEval(&a, xs, count) == PolyTapeEval(tape, xs, count);
+    PolyTapeDestroy(tape);
+    PolyDestroy(&a);
+    return is_eq;
+}
+
+static bool EvalTest(void) {
+    bool res = true;
+    const poly_coeff_t xs[] = {2, -3, 5};
+    res &= TestEval(C(7), xs, 0, 7);
+    res &= TestEval(POLY_P, xs, 2, 17);
+    res &= TestEval(P(P(P(C(3), 2), 0, C(1), 1), 5, C(2), 6), xs, 3, 2432);
+    // Zmienne spoza tablicy wartości przyjmują wartość 0.
+    res &= TestEval(POLY_P, xs, 1, 8);
+    res &= TestEval(POLY_P, xs, 0, 0);
+    res &= TestEval(P(P(P(C(3), 2), 0, C(1), 1), 5, C(2), 6), xs, 2, 32);
+    res &= TestEval(P(C(4), 0, P(C(1), 1), 2), xs, 1, 4);
+    // Wykładniki powyżej stablicowanych potęg są liczone szybkim potęgowaniem.
+    const poly_coeff_t minusOne[] = {-1}, three[] = {3};
+    res &= TestEval(P(C(3), 4095, C(1), 4096, C(1), 5001), minusOne, 1, -3);
+    res &= TestEval(P(C(1), 0, C(1), 5000), xs, 1, 1);
+    res &= TestEvalMatchesTape(P(C(3), 4095, C(1), 4096, C(1), 5001), three, 1);
+    res &= TestEvalMatchesTape(P(P(C(1), 5000), 1, C(2), 4097), three, 1);
+    return res;
+}
+
 int main() {
     assert(SimpleAddTest());
     assert(SimpleAddMonosTest());
@@ -320,4 +477,7 @@ int main() {
     assert(SimpleIsEqTest());
     assert(SimpleAtTest());
     assert(OverflowTest());
+    assert(SimpleMoveTest());
+    assert(PackedTest());
+    assert(EvalTest());
 }
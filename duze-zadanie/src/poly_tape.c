@@ -0,0 +1,238 @@
+/** @file
+ * Implementacja skompilowanych wielomianów.
+ *
+ * Węzeł @f$\sum_{i} c_i x^{e_i}@f$ o rosnących wykładnikach jest kompilowany do schematu Hornera
+ * @f$(\ldots(c_{n-1} x^{e_{n-1} - e_{n-2}} + c_{n-2}) \ldots + c_0) x^{e_0}@f$. Każda różnica
+ * wykładników staje się odwołaniem do potęgi wartości zmiennej, a różne potęgi są liczone raz na
+ * wyliczenie, przed przejściem po taśmie.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#include "poly_tape.h"
+#include "coeff_ring.h"
+#include "safe_memory_allocation.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Liczba potęg i pozycji stosu, dla których PolyTapeEval nie przydziela pamięci.
+ */
+#define TAPE_LOCAL_BUFFER_SIZE 64
+
+/**
+ * Rodzaj instrukcji taśmy. Wierzchołek stosu oznaczamy @f$t@f$, a potęgę wskazaną przez
+ * instrukcję @f$w@f$.
+ */
+typedef enum {
+    TAPE_PUSH,          ///< wstawia na stos współczynnik
+    TAPE_MUL_ADD_CONST, ///< @f$t \gets t \cdot w + c@f$
+    TAPE_MUL_ADD,       ///< zdejmuje @f$v@f$ ze stosu, a potem @f$t \gets t \cdot w + v@f$
+    TAPE_MUL,           ///< @f$t \gets t \cdot w@f$
+} TapeOp;
+
+/**
+ * Instrukcja taśmy.
+ */
+typedef struct {
+    TapeOp op;          ///< rodzaj instrukcji
+    uint32_t power;     ///< indeks potęgi w tablicy potęg taśmy
+    poly_coeff_t coeff; ///< współczynnik instrukcji TAPE_PUSH i TAPE_MUL_ADD_CONST
+} TapeInstruction;
+
+/**
+ * Potęga wartości zmiennej używana przez taśmę.
+ */
+typedef struct {
+    size_t var;     ///< indeks zmiennej
+    poly_exp_t exp; ///< wykładnik
+} TapePower;
+
+/**
+ * Skompilowany wielomian.
+ */
+struct PolyTape {
+    TapeInstruction *code; ///< instrukcje
+    size_t length;         ///< liczba instrukcji
+    TapePower *powers;     ///< potęgi posortowane po zmiennych, a potem po wykładnikach
+    size_t powerCount;     ///< liczba potęg
+    size_t maxDepth;       ///< największa głębokość stosu podczas wykonania
+};
+
+/**
+ * Stan kompilacji: budowana taśma i potęgi kolejnych instrukcji przed nadaniem im indeksów.
+ */
+typedef struct {
+    PolyTape *tape;         ///< budowana taśma
+    size_t capacity;        ///< pojemność tablic instrukcji i potęg
+    TapePower *instrPowers; ///< potęga każdej instrukcji
+    size_t depth;           ///< aktualna głębokość stosu
+} TapeBuilder;
+
+/**
+ * Dopisuje instrukcję na koniec taśmy.
+ * @param builder : stan kompilacji,
+ * @param op : rodzaj instrukcji,
+ * @param var : indeks zmiennej potęgi,
+ * @param exp : wykładnik potęgi,
+ * @param coeff : współczynnik.
+ */
+static void Emit(TapeBuilder *builder, TapeOp op, size_t var, poly_exp_t exp,
+                 poly_coeff_t coeff) {
+    PolyTape *tape = builder->tape;
+    if (tape->length == builder->capacity) {
+        builder->capacity = builder->capacity == 0 ? 16 : 2 * builder->capacity;
+        tape->code = SafeRealloc(tape->code, builder->capacity * sizeof(TapeInstruction));
+        builder->instrPowers =
+            SafeRealloc(builder->instrPowers, builder->capacity * sizeof(TapePower));
+    }
+    tape->code[tape->length] = (TapeInstruction){.op = op, .power = 0, .coeff = coeff};
+    builder->instrPowers[tape->length++] = (TapePower){.var = var, .exp = exp};
+
+    if (op == TAPE_PUSH) {
+        if (++builder->depth > tape->maxDepth) {
+            tape->maxDepth = builder->depth;
+        }
+    } else if (op == TAPE_MUL_ADD) {
+        builder->depth--;
+    }
+}
+
+/**
+ * Kompiluje wielomian, którego pierwszą zmienną jest zmienna o indeksie @p var. Wykonanie
+ * wygenerowanych instrukcji wstawia na stos jego wartość.
+ * @param builder : stan kompilacji,
+ * @param p : wielomian,
+ * @param var : indeks pierwszej zmiennej wielomianu.
+ */
+static void EmitPoly(TapeBuilder *builder, const Poly *p, size_t var) {
+    if (PolyIsCoeff(p)) {
+        Emit(builder, TAPE_PUSH, 0, 0, p->coeff);
+        return;
+    }
+
+    EmitPoly(builder, &p->arr[p->size - 1].p, var + 1);
+    for (size_t i = p->size - 1; i-- > 0;) {
+        const Poly *coeff = &p->arr[i].p;
+        poly_exp_t gap = MonoGetExp(&p->arr[i + 1]) - MonoGetExp(&p->arr[i]);
+        if (PolyIsCoeff(coeff)) {
+            Emit(builder, TAPE_MUL_ADD_CONST, var, gap, coeff->coeff);
+        } else {
+            EmitPoly(builder, coeff, var + 1);
+            Emit(builder, TAPE_MUL_ADD, var, gap, 0);
+        }
+    }
+    if (MonoGetExp(&p->arr[0]) > 0) {
+        Emit(builder, TAPE_MUL, var, MonoGetExp(&p->arr[0]), 0);
+    }
+}
+
+/**
+ * Porównuje potęgi najpierw po zmiennych, a potem po wykładnikach.
+ * @param a : wskaźnik na pierwszą potęgę,
+ * @param b : wskaźnik na drugą potęgę,
+ * @return liczba ujemna, zero albo dodatnia, zależnie od kolejności potęg.
+ */
+static int ComparePowers(const void *a, const void *b) {
+    const TapePower *x = a, *y = b;
+    if (x->var != y->var) {
+        return x->var < y->var ? -1 : 1;
+    }
+    return (x->exp > y->exp) - (x->exp < y->exp);
+}
+
+PolyTape *PolyCompile(const Poly *p) {
+    PolyTape *tape = SafeMalloc(sizeof(PolyTape));
+    *tape = (PolyTape){.code = NULL, .length = 0, .powers = NULL, .powerCount = 0,
+                       .maxDepth = 0};
+    TapeBuilder builder = {.tape = tape, .capacity = 0, .instrPowers = NULL, .depth = 0};
+    EmitPoly(&builder, p, 0);
+
+    // Zostawiamy różne potęgi instrukcji, pomijając instrukcje TAPE_PUSH, które ich nie używają.
+    tape->powers = SafeMalloc((tape->length + 1) * sizeof(TapePower));
+    for (size_t i = 0; i < tape->length; i++) {
+        if (tape->code[i].op != TAPE_PUSH) {
+            tape->powers[tape->powerCount++] = builder.instrPowers[i];
+        }
+    }
+    qsort(tape->powers, tape->powerCount, sizeof(TapePower), ComparePowers);
+    size_t unique = 0;
+    for (size_t i = 0; i < tape->powerCount; i++) {
+        if (unique == 0 || ComparePowers(&tape->powers[unique - 1], &tape->powers[i]) != 0) {
+            tape->powers[unique++] = tape->powers[i];
+        }
+    }
+    tape->powerCount = unique;
+
+    for (size_t i = 0; i < tape->length; i++) {
+        if (tape->code[i].op != TAPE_PUSH) {
+            const TapePower *power = bsearch(&builder.instrPowers[i], tape->powers, unique,
+                                             sizeof(TapePower), ComparePowers);
+            tape->code[i].power = (uint32_t)(power - tape->powers);
+        }
+    }
+    free(builder.instrPowers);
+
+    return tape;
+}
+
+poly_coeff_t PolyTapeEval(const PolyTape *tape, const poly_coeff_t *xs, size_t varCount) {
+    unsigned long localPowers[TAPE_LOCAL_BUFFER_SIZE], localStack[TAPE_LOCAL_BUFFER_SIZE];
+    unsigned long *powers = tape->powerCount <= TAPE_LOCAL_BUFFER_SIZE
+                                ? localPowers
+                                : SafeMalloc(tape->powerCount * sizeof(unsigned long));
+    unsigned long *stack = tape->maxDepth <= TAPE_LOCAL_BUFFER_SIZE
+                               ? localStack
+                               : SafeMalloc(tape->maxDepth * sizeof(unsigned long));
+
+    // Potęgi jednej zmiennej są posortowane, więc każdą liczymy z poprzedniej.
+    for (size_t i = 0; i < tape->powerCount; i++) {
+        const TapePower *power = &tape->powers[i];
+        unsigned long x = power->var < varCount ? CoeffFromLong(xs[power->var]) : 0;
+        if (i > 0 && tape->powers[i - 1].var == power->var) {
+            unsigned long gap = (unsigned long)(power->exp - tape->powers[i - 1].exp);
+            powers[i] = CoeffMul(powers[i - 1], CoeffPow(x, gap));
+        } else {
+            powers[i] = CoeffPow(x, (unsigned long)power->exp);
+        }
+    }
+
+    size_t top = 0;
+    for (const TapeInstruction *instr = tape->code; instr < tape->code + tape->length; instr++) {
+        switch (instr->op) {
+            case TAPE_PUSH:
+                stack[top++] = (unsigned long)instr->coeff;
+                break;
+            case TAPE_MUL_ADD_CONST:
+                stack[top - 1] = CoeffAdd(CoeffMul(stack[top - 1], powers[instr->power]),
+                                          (unsigned long)instr->coeff);
+                break;
+            case TAPE_MUL_ADD:
+                top--;
+                stack[top - 1] =
+                    CoeffAdd(CoeffMul(stack[top - 1], powers[instr->power]), stack[top]);
+                break;
+            case TAPE_MUL:
+                stack[top - 1] = CoeffMul(stack[top - 1], powers[instr->power]);
+                break;
+        }
+    }
+    poly_coeff_t result = (poly_coeff_t)stack[0];
+
+    if (powers != localPowers) {
+        free(powers);
+    }
+    if (stack != localStack) {
+        free(stack);
+    }
+
+    return result;
+}
+
+void PolyTapeDestroy(PolyTape *tape) {
+    free(tape->code);
+    free(tape->powers);
+    free(tape);
+}
@@ -0,0 +1,48 @@
+/** @file
+ * Interfejs skompilowanych wielomianów (taśm obliczeniowych).
+ *
+ * Taśma to płaski ciąg instrukcji maszyny stosowej, który wylicza wartość wielomianu schematem
+ * Hornera. Przejście po taśmie nie wymaga rekurencji ani przechodzenia po wskaźnikach drzewa,
+ * więc taśma opłaca się, gdy ten sam wielomian jest wyliczany wielokrotnie.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#ifndef POLYNOMIALS_POLY_TAPE_H
+#define POLYNOMIALS_POLY_TAPE_H
+
+#include "poly.h"
+#include <stddef.h>
+
+/**
+ * Skompilowany wielomian.
+ */
+typedef struct PolyTape PolyTape;
+
+/**
+ * Kompiluje wielomian do taśmy. Taśma nie odwołuje się do wielomianu, więc wielomian można
+ * potem usunąć albo zmienić.
+ * @param p : wielomian,
+ * @return taśma, którą należy zwolnić funkcją PolyTapeDestroy.
+ */
+PolyTape *PolyCompile(const Poly *p);
+
+/**
+ * Wylicza wartość skompilowanego wielomianu, wstawiając pod zmienne podane wartości (patrz
+ * PolyEval). Zmienne o indeksach nie mniejszych niż @p varCount przyjmują wartość 0.
+ * @param tape : taśma,
+ * @param xs : wartości zmiennych @f$x_0, x_1, \ldots@f$,
+ * @param varCount : liczba wartości w tablicy @p xs,
+ * @return wartość wielomianu.
+ */
+poly_coeff_t PolyTapeEval(const PolyTape *tape, const poly_coeff_t *xs, size_t varCount);
+
+/**
+ * Usuwa taśmę z pamięci.
+ * @param tape : taśma.
+ */
+void PolyTapeDestroy(PolyTape *tape);
+
+#endif // POLYNOMIALS_POLY_TAPE_H
@@ -0,0 +1,402 @@
+/** @file
+ * Implementacja przydziału tablic jednomianów.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#include "safe_memory_allocation.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Liczba klas rozmiarów płyt. Klasa c obejmuje tablice o pojemności 2^c jednomianów.
+ */
+#define SLAB_CLASS_COUNT 4
+
+/**
+ * Największa liczba jednomianów tablicy przydzielanej z płyty.
+ */
+#define SLAB_MAX_COUNT (1 << (SLAB_CLASS_COUNT - 1))
+
+/**
+ * Rozmiar strony dzielonej na bloki jednej klasy.
+ */
+#define SLAB_PAGE_SIZE (64 * 1024)
+
+/**
+ * Sposób przydzielenia tablicy jednomianów.
+ */
+typedef enum {
+    MONO_ARRAY_MALLOC, ///< funkcją malloc
+    MONO_ARRAY_SLAB,   ///< z płyty
+    MONO_ARRAY_ARENA,  ///< w arenie, z przedrostkiem wskazującym arenę
+    MONO_ARRAY_SHARED  ///< funkcją malloc, z przedrostkiem na licznik odwołań
+} MonoArrayKind;
+
+/**
+ * Nagłówek umieszczany przed każdą tablicą jednomianów. Zajmuje 24 bajty, z czego 16 zajmują
+ * zapamiętane skrót i stopnie wielomianu, używane niezależnie od opcji programu.
+ */
+typedef struct {
+    uint32_t capacity;              ///< liczba jednomianów, na którą przydzielono tablicę
+    uint8_t kind;                   ///< sposób przydzielenia tablicy (MonoArrayKind)
+    bool regionRoot;                ///< czy zwolnienie tablicy zwalnia całą arenę
+    bool interned;                  ///< czy tablica jest współdzielonym węzłem z tablicy węzłów
+    atomic_size_t hash;             ///< zapamiętany skrót wielomianu albo 0
+    _Atomic(PolyDegrees *) degrees; ///< zapamiętane stopnie wielomianu albo NULL
+} MonoArrayHeader;
+
+/**
+ * Przedrostek umieszczany przed nagłówkiem tablic z areny i tablic, które mogą stać się
+ * współdzielonymi węzłami. Pozostałe tablice go nie mają: 24-bajtowy nagłówek poprzedza
+ * każdą tablicę, a od opcji -a i -i zależy tylko te dodatkowe 8 bajtów przedrostka.
+ */
+typedef union {
+    Arena *arena;         ///< arena, w której przydzielono tablicę rodzaju MONO_ARRAY_ARENA
+    atomic_uint refCount; ///< liczba odwołań do tablicy rodzaju MONO_ARRAY_SHARED
+} MonoArrayPrefix;
+
+_Static_assert(sizeof(MonoArrayHeader) % _Alignof(Mono) == 0 &&
+               sizeof(MonoArrayPrefix) % _Alignof(MonoArrayHeader) == 0,
+               "tablica jednomianów musi być wyrównana");
+
+/**
+ * Wolny blok płyty. Wolne bloki jednej klasy tworzą listę.
+ */
+typedef struct SlabBlock {
+    struct SlabBlock *next; ///< następny wolny blok
+} SlabBlock;
+
+/**
+ * Strona płyty. Strony nie są zwalniane; lista stron utrzymuje je osiągalne do końca programu.
+ * Oddanie strony wymagałoby liczenia zajętych bloków każdej strony i usuwania jej bloków
+ * z list wszystkich wątków, a płyty obsługują tablice, które szybko są ponownie przydzielane.
+ */
+typedef struct SlabPage {
+    struct SlabPage *next; ///< następna strona
+} SlabPage;
+
+/**
+ * Wszystkie strony płyt, wspólne dla wątków.
+ */
+static struct {
+    pthread_mutex_t lock; ///< blokada chroniąca listę stron
+    SlabPage *pages;      ///< lista stron
+} slabPages = {.lock = PTHREAD_MUTEX_INITIALIZER, .pages = NULL};
+
+/**
+ * Listy wolnych bloków bieżącego wątku, po jednej dla każdej klasy. Blok zwolniony przez inny
+ * wątek niż ten, który go przydzielił, trafia na listę zwalniającego.
+ */
+static _Thread_local SlabBlock *freeBlocks[SLAB_CLASS_COUNT];
+
+/**
+ * Arena, w której bieżący wątek przydziela tablice jednomianów.
+ */
+static _Thread_local Arena *currentArena = NULL;
+
+/**
+ * Zwraca nagłówek tablicy jednomianów.
+ * @param monos : tablica jednomianów,
+ * @return wskaźnik na nagłówek.
+ */
+static inline MonoArrayHeader *HeaderOf(const Mono *monos) {
+    return (MonoArrayHeader *)monos - 1;
+}
+
+/**
+ * Zwraca przedrostek tablicy przydzielonej w arenie albo tablicy, która może być współdzielona.
+ * @param header : nagłówek tablicy z przedrostkiem,
+ * @return wskaźnik na przedrostek.
+ */
+static inline MonoArrayPrefix *PrefixOf(const MonoArrayHeader *header) {
+    return (MonoArrayPrefix *)header - 1;
+}
+
+/**
+ * Wyznacza najmniejszą klasę płyty mieszczącą tablicę.
+ * @param count : liczba jednomianów, nie większa niż SLAB_MAX_COUNT,
+ * @return klasa płyty.
+ */
+static inline size_t SlabClassOf(size_t count) {
+    size_t slabClass = 0;
+    while (((size_t)1 << slabClass) < count) {
+        slabClass++;
+    }
+    return slabClass;
+}
+
+/**
+ * Zwraca rozmiar bloku klasy płyty wraz z nagłówkiem tablicy.
+ * @param slabClass : klasa płyty,
+ * @return rozmiar bloku w bajtach.
+ */
+static inline size_t SlabBlockSize(size_t slabClass) {
+    return sizeof(MonoArrayHeader) + ((size_t)1 << slabClass) * sizeof(Mono);
+}
+
+/**
+ * Dzieli nową stronę na bloki danej klasy i umieszcza je na liście wolnych bloków bieżącego
+ * wątku.
+ * @param slabClass : klasa płyty.
+ */
+static void RefillSlab(size_t slabClass) {
+    SlabPage *page = SafeMalloc(SLAB_PAGE_SIZE);
+    pthread_mutex_lock(&slabPages.lock);
+    page->next = slabPages.pages;
+    slabPages.pages = page;
+    pthread_mutex_unlock(&slabPages.lock);
+
+    size_t blockSize = SlabBlockSize(slabClass);
+    char *block = (char *)(page + 1);
+    char *end = (char *)page + SLAB_PAGE_SIZE;
+    while (end - block >= (ptrdiff_t)blockSize) {
+        ((SlabBlock *)block)->next = freeBlocks[slabClass];
+        freeBlocks[slabClass] = (SlabBlock *)block;
+        block += blockSize;
+    }
+}
+
+/**
+ * Przydziela tablicę jednomianów z płyty.
+ * @param count : liczba jednomianów, nie większa niż SLAB_MAX_COUNT,
+ * @return wskaźnik na nagłówek tablicy.
+ */
+static MonoArrayHeader *SlabAlloc(size_t count) {
+    size_t slabClass = SlabClassOf(count);
+    if (freeBlocks[slabClass] == NULL) {
+        RefillSlab(slabClass);
+    }
+
+    SlabBlock *block = freeBlocks[slabClass];
+    freeBlocks[slabClass] = block->next;
+    MonoArrayHeader *header = (MonoArrayHeader *)block;
+    *header = (MonoArrayHeader){.capacity = (uint32_t)1 << slabClass, .kind = MONO_ARRAY_SLAB,
+                                .regionRoot = false, .interned = false, .hash = 0,
+                                .degrees = NULL};
+
+    return header;
+}
+
+/**
+ * Zwraca blok tablicy na listę wolnych bloków płyty bieżącego wątku.
+ * @param header : nagłówek tablicy przydzielonej z płyty.
+ */
+static void SlabFree(MonoArrayHeader *header) {
+    size_t slabClass = SlabClassOf(header->capacity);
+    SlabBlock *block = (SlabBlock *)header;
+    block->next = freeBlocks[slabClass];
+    freeBlocks[slabClass] = block;
+}
+
+/**
+ * Przydziela tablicę jednomianów z nagłówkiem w danej arenie, a bez areny - z płyty albo,
+ * dla większych tablic, funkcją malloc.
+ * @param arena : arena albo NULL,
+ * @param count : liczba jednomianów,
+ * @return wskaźnik na tablicę.
+ */
+static Mono *AllocIn(Arena *arena, size_t count) {
+    if (arena == NULL && count <= SLAB_MAX_COUNT) {
+        return (Mono *)(SlabAlloc(count) + 1);
+    }
+    if (count > UINT32_MAX) { // Taka tablica zajęłaby ponad 96 GiB.
+        exit(EXIT_FAILURE);
+    }
+
+    MonoArrayHeader *header;
+    size_t size = sizeof(MonoArrayHeader) + count * sizeof(Mono);
+    if (arena != NULL) {
+        MonoArrayPrefix *prefix = ArenaAlloc(arena, sizeof(MonoArrayPrefix) + size);
+        prefix->arena = arena;
+        header = (MonoArrayHeader *)(prefix + 1);
+    } else {
+        header = SafeMalloc(size);
+    }
+    *header = (MonoArrayHeader){.capacity = (uint32_t)count,
+                                .kind = arena != NULL ? MONO_ARRAY_ARENA : MONO_ARRAY_MALLOC,
+                                .regionRoot = false, .interned = false, .hash = 0,
+                                .degrees = NULL};
+
+    return (Mono *)(header + 1);
+}
+
+Mono *SafeMonoArrayAlloc(size_t count) {
+    return AllocIn(currentArena, count);
+}
+
+Mono *SafeMonoArrayAllocShared(size_t count) {
+    if (count > UINT32_MAX) {
+        exit(EXIT_FAILURE);
+    }
+
+    MonoArrayPrefix *prefix =
+            SafeMalloc(sizeof(MonoArrayPrefix) + sizeof(MonoArrayHeader) + count * sizeof(Mono));
+    MonoArrayHeader *header = (MonoArrayHeader *)(prefix + 1);
+    *header = (MonoArrayHeader){.capacity = (uint32_t)count, .kind = MONO_ARRAY_SHARED,
+                                .regionRoot = false, .interned = false, .hash = 0,
+                                .degrees = NULL};
+
+    return (Mono *)(header + 1);
+}
+
+Mono *SafeMonoArrayRealloc(Mono *monos, size_t count) {
+    if (monos == NULL) {
+        return SafeMonoArrayAlloc(count);
+    }
+
+    MonoArrayHeader *header = HeaderOf(monos);
+    MonoArrayInvalidate(monos);
+    if (header->kind == MONO_ARRAY_SLAB) {
+        if (count <= header->capacity) {
+            return monos;
+        }
+        Mono *result = AllocIn(NULL, count);
+        memcpy(result, monos, header->capacity * sizeof(Mono));
+        SlabFree(header);
+        return result;
+    }
+    if (header->kind != MONO_ARRAY_ARENA) {
+        if (count > UINT32_MAX) {
+            exit(EXIT_FAILURE);
+        }
+        size_t size = sizeof(MonoArrayHeader) + count * sizeof(Mono);
+        if (header->kind == MONO_ARRAY_SHARED) {
+            MonoArrayPrefix *prefix = SafeRealloc(PrefixOf(header), sizeof(MonoArrayPrefix) + size);
+            header = (MonoArrayHeader *)(prefix + 1);
+        } else {
+            header = SafeRealloc(header, size);
+        }
+        header->capacity = (uint32_t)count;
+        return (Mono *)(header + 1);
+    }
+    if (count <= header->capacity) {
+        return monos;
+    }
+
+    // Korzeń regionu musi pozostać w arenie regionu, pozostałe tablice trafiają do bieżącej.
+    // Porzucony przydział zajmuje arenę do jej zwolnienia, więc korzeń rośnie geometrycznie.
+    if (header->regionRoot && count < 2 * (size_t)header->capacity) {
+        count = 2 * (size_t)header->capacity;
+    }
+    Arena *arena = header->regionRoot ? PrefixOf(header)->arena : currentArena;
+    Mono *result = AllocIn(arena, count);
+    memcpy(result, monos, header->capacity * sizeof(Mono));
+    HeaderOf(result)->regionRoot = header->regionRoot;
+
+    return result;
+}
+
+void MonoArrayFree(Mono *monos) {
+    if (monos == NULL) {
+        return;
+    }
+
+    MonoArrayHeader *header = HeaderOf(monos);
+    free(atomic_load_explicit(&header->degrees, memory_order_relaxed));
+    switch ((MonoArrayKind)header->kind) {
+        case MONO_ARRAY_MALLOC:
+            free(header);
+            break;
+        case MONO_ARRAY_SLAB:
+            SlabFree(header);
+            break;
+        case MONO_ARRAY_ARENA:
+            if (header->regionRoot) {
+                ArenaDestroy(PrefixOf(header)->arena);
+            }
+            break;
+        case MONO_ARRAY_SHARED:
+            free(PrefixOf(header));
+            break;
+    }
+}
+
+Arena *MonoArraySetArena(Arena *arena) {
+    Arena *previous = currentArena;
+    currentArena = arena;
+    return previous;
+}
+
+void MonoArrayMarkRegionRoot(Mono *monos) {
+    HeaderOf(monos)->regionRoot = true;
+}
+
+bool MonoArrayIsRegionRoot(const Mono *monos) {
+    return HeaderOf(monos)->regionRoot;
+}
+
+void MonoArrayMarkInterned(Mono *monos) {
+    MonoArrayHeader *header = HeaderOf(monos);
+    header->interned = true;
+    atomic_init(&PrefixOf(header)->refCount, 1);
+}
+
+bool MonoArrayIsInterned(const Mono *monos) {
+    return HeaderOf(monos)->interned;
+}
+
+void MonoArrayRetain(Mono *monos) {
+    atomic_fetch_add_explicit(&PrefixOf(HeaderOf(monos))->refCount, 1, memory_order_relaxed);
+}
+
+bool MonoArrayTryRetain(Mono *monos) {
+    atomic_uint *refCount = &PrefixOf(HeaderOf(monos))->refCount;
+    unsigned count = atomic_load(refCount);
+    while (count > 0) {
+        if (atomic_compare_exchange_weak(refCount, &count, count + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MonoArrayRelease(Mono *monos) {
+    atomic_uint *refCount = &PrefixOf(HeaderOf(monos))->refCount;
+    return atomic_fetch_sub_explicit(refCount, 1, memory_order_acq_rel) == 1;
+}
+
+Arena *MonoArrayArena(const Mono *monos) {
+    const MonoArrayHeader *header = HeaderOf(monos);
+    return header->kind == MONO_ARRAY_ARENA ? PrefixOf(header)->arena : NULL;
+}
+
+size_t MonoArrayCachedHash(const Mono *monos) {
+    return atomic_load_explicit(&HeaderOf(monos)->hash, memory_order_relaxed);
+}
+
+void MonoArraySetCachedHash(const Mono *monos, size_t hash) {
+    atomic_store_explicit(&HeaderOf(monos)->hash, hash, memory_order_relaxed);
+}
+
+const PolyDegrees *MonoArrayCachedDegrees(const Mono *monos) {
+    return atomic_load_explicit(&HeaderOf(monos)->degrees, memory_order_acquire);
+}
+
+const PolyDegrees *MonoArrayCacheDegrees(const Mono *monos, PolyDegrees *degrees) {
+    PolyDegrees *expected = NULL;
+    if (!atomic_compare_exchange_strong(&HeaderOf(monos)->degrees, &expected, degrees)) {
+        free(degrees);
+        return expected;
+    }
+    return degrees;
+}
+
+bool MonoArrayInArena(const Mono *monos) {
+    return HeaderOf(monos)->kind == MONO_ARRAY_ARENA;
+}
+
+void MonoArrayInvalidate(Mono *monos) {
+    MonoArrayHeader *header = HeaderOf(monos);
+    atomic_store_explicit(&header->hash, 0, memory_order_relaxed);
+    free(atomic_exchange_explicit(&header->degrees, NULL, memory_order_relaxed));
+}
+
+size_t MonoArrayAllocationSize(size_t count) {
+    return ArenaAllocationSize(sizeof(MonoArrayPrefix) + sizeof(MonoArrayHeader) +
+                               count * sizeof(Mono));
+}
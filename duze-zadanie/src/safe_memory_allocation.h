@@ -1,5 +1,5 @@
 /** @file
- * Interfejs obsługujący błędy związane z alokacją pamięci.
+ * Interfejs obsługujący błędy związane z alokacją pamięci oraz przydział tablic jednomianów.
  *
  * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
  * @copyright Uniwersytet Warszawski
@@ -9,8 +9,20 @@
 #ifndef SAFE_MEMORY_ALLOCATION_H
 #define SAFE_MEMORY_ALLOCATION_H
 
+#include "arena.h"
+#include "poly.h"
+#include <stdbool.h>
 #include <stdlib.h>
 
+/**
+ * Stopnie wielomianu niestałego zapamiętywane w nagłówku tablicy jego jednomianów.
+ */
+typedef struct {
+    poly_exp_t deg;     ///< stopień wielomianu
+    size_t varCount;    ///< liczba zmiennych, od których wielomian może zależeć
+    poly_exp_t degBy[]; ///< stopnie wielomianu ze względu na kolejne zmienne
+} PolyDegrees;
+
 /**
  * Sprawdza, czy malloc nie zwrócił błędu.
  * @param size : rozmiar pamięci do zaalokowania,
@@ -25,6 +37,21 @@ static inline void *SafeMalloc(size_t size) {
     return malloc_ptr;
 }
 
+/**
+ * Sprawdza, czy calloc nie zwrócił błędu.
+ * @param count : liczba elementów do zaalokowania,
+ * @param size : rozmiar jednego elementu,
+ * @return jeśli calloc zwrócił NULL, kończy program z błędem 1. W przeciwnym
+ * przypadku zwraca to, co zwrócił calloc.
+ */
+static inline void *SafeCalloc(size_t count, size_t size) {
+    void *calloc_ptr = calloc(count, size);
+    if (calloc_ptr == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    return calloc_ptr;
+}
+
 /**
  * Sprawdza, czy realloc nie zwrócił błędu.
  * @param size : rozmiar pamięci do zaalokowania,
@@ -39,4 +66,161 @@ static inline void *SafeRealloc(void *ptr, size_t size) {
     return realloc_ptr;
 }
 
+/**
+ * Przydziela tablicę jednomianów. Przed tablicą umieszczany jest ukryty nagłówek, więc tablice
+ * jednomianów wielomianów wolno przydzielać, powiększać i zwalniać wyłącznie funkcjami z tej
+ * grupy. Jeśli w bieżącym wątku ustawiono arenę (patrz MonoArraySetArena), tablica jest
+ * przydzielana w niej. W przeciwnym razie małe tablice są przydzielane z płyt (ang. slab) -
+ * list wolnych bloków kilku klas rozmiarów, prowadzonych osobno w każdym wątku - a większe
+ * funkcją malloc. Strony płyt nie są oddawane systemowi aż do końca programu, więc pamięć
+ * zajęta przez płyty nie maleje po usunięciu wielomianów. Blok zwolniony w innym wątku niż ten,
+ * który go przydzielił, trafia na listę wolnych bloków zwalniającego wątku; przy mnożeniu
+ * w puli wątków bloki mogą więc przechodzić między wątkami, a bloki z list kończącego się
+ * wątku nie są już ponownie używane.
+ * @param count : liczba jednomianów,
+ * @return wskaźnik na tablicę; w razie braku pamięci kończy program z błędem 1.
+ */
+Mono *SafeMonoArrayAlloc(size_t count);
+
+/**
+ * Przydziela funkcją malloc tablicę jednomianów, która może zostać współdzielonym węzłem (patrz
+ * MonoArrayMarkInterned). Przed nagłówkiem takiej tablicy jest miejsce na licznik odwołań,
+ * więc tablica nie trafia do areny ani na płytę.
+ * @param count : liczba jednomianów,
+ * @return wskaźnik na tablicę; w razie braku pamięci kończy program z błędem 1.
+ */
+Mono *SafeMonoArrayAllocShared(size_t count);
+
+/**
+ * Zmienia rozmiar tablicy jednomianów, zachowując jej początkowe elementy. Tablica z areny
+ * jest zmniejszana w miejscu, a powiększana przez skopiowanie do nowego przydziału; korzeń
+ * regionu dostaje przy tym co najmniej dwa razy większy przydział, więc kolejne powiększenia
+ * zwykle mieszczą się w miejscu. Informacje zapamiętane w nagłówku tablicy są unieważniane.
+ * @param monos : tablica przydzielona przez SafeMonoArrayAlloc albo NULL,
+ * @param count : nowa liczba jednomianów,
+ * @return wskaźnik na tablicę; w razie braku pamięci kończy program z błędem 1.
+ */
+Mono *SafeMonoArrayRealloc(Mono *monos, size_t count);
+
+/**
+ * Zwalnia tablicę jednomianów. Zwolnienie tablicy z areny nic nie robi, chyba że tablica jest
+ * korzeniem regionu - wtedy zwalniana jest cała arena regionu.
+ * @param monos : tablica przydzielona przez SafeMonoArrayAlloc albo NULL.
+ */
+void MonoArrayFree(Mono *monos);
+
+/**
+ * Ustawia arenę, w której bieżący wątek przydziela nowe tablice jednomianów.
+ * @param arena : arena albo NULL, aby przydzielać tablice funkcją malloc,
+ * @return poprzednio ustawiona arena.
+ */
+Arena *MonoArraySetArena(Arena *arena);
+
+/**
+ * Oznacza tablicę z areny jako korzeń regionu: od tej chwili zwolnienie tablicy zwalnia całą
+ * arenę, w której ją przydzielono.
+ * @param monos : tablica przydzielona w arenie.
+ */
+void MonoArrayMarkRegionRoot(Mono *monos);
+
+/**
+ * Sprawdza, czy tablica jest korzeniem regionu.
+ * @param monos : tablica jednomianów,
+ * @return Czy zwolnienie tablicy zwalnia cały region?
+ */
+bool MonoArrayIsRegionRoot(const Mono *monos);
+
+/**
+ * Oznacza tablicę przydzieloną przez SafeMonoArrayAllocShared jako współdzielony węzeł
+ * z licznikiem odwołań równym 1. Współdzielonej tablicy nie wolno modyfikować.
+ * @param monos : tablica jednomianów.
+ */
+void MonoArrayMarkInterned(Mono *monos);
+
+/**
+ * Sprawdza, czy tablica jest współdzielonym węzłem.
+ * @param monos : tablica jednomianów,
+ * @return Czy tablica jest współdzielona?
+ */
+bool MonoArrayIsInterned(const Mono *monos);
+
+/**
+ * Zwiększa licznik odwołań do współdzielonego węzła.
+ * @param monos : współdzielona tablica jednomianów.
+ */
+void MonoArrayRetain(Mono *monos);
+
+/**
+ * Zwiększa licznik odwołań do współdzielonego węzła, o ile węzeł nie jest właśnie usuwany.
+ * @param monos : współdzielona tablica jednomianów,
+ * @return false, jeśli licznik odwołań był równy 0.
+ */
+bool MonoArrayTryRetain(Mono *monos);
+
+/**
+ * Zmniejsza licznik odwołań do współdzielonego węzła.
+ * @param monos : współdzielona tablica jednomianów,
+ * @return Czy było to ostatnie odwołanie?
+ */
+bool MonoArrayRelease(Mono *monos);
+
+/**
+ * Zwraca arenę, w której przydzielono tablicę.
+ * @param monos : tablica jednomianów,
+ * @return arena albo NULL, jeśli tablicy nie przydzielono w arenie.
+ */
+Arena *MonoArrayArena(const Mono *monos);
+
+/**
+ * Zwraca skrót wielomianu zapamiętany w nagłówku tablicy jego jednomianów.
+ * @param monos : tablica jednomianów,
+ * @return skrót albo 0, jeśli nie został zapamiętany.
+ */
+size_t MonoArrayCachedHash(const Mono *monos);
+
+/**
+ * Zapamiętuje w nagłówku tablicy skrót wielomianu. Nagłówek nie jest częścią wartości
+ * wielomianu, więc można go uzupełniać także w tablicach dostępnych tylko do odczytu.
+ * @param monos : tablica jednomianów,
+ * @param hash : niezerowy skrót.
+ */
+void MonoArraySetCachedHash(const Mono *monos, size_t hash);
+
+/**
+ * Zwraca stopnie wielomianu zapamiętane w nagłówku tablicy jego jednomianów.
+ * @param monos : tablica jednomianów,
+ * @return stopnie albo NULL, jeśli nie zostały zapamiętane.
+ */
+const PolyDegrees *MonoArrayCachedDegrees(const Mono *monos);
+
+/**
+ * Zapamiętuje w nagłówku tablicy spoza areny stopnie wielomianu. Jeśli inny wątek zdążył już
+ * zapamiętać stopnie, podane są zwalniane.
+ * @param monos : tablica jednomianów spoza areny,
+ * @param degrees : stopnie przydzielone funkcją malloc, przejmowane na własność,
+ * @return zapamiętane stopnie.
+ */
+const PolyDegrees *MonoArrayCacheDegrees(const Mono *monos, PolyDegrees *degrees);
+
+/**
+ * Sprawdza, czy tablicę przydzielono w arenie.
+ * @param monos : tablica jednomianów,
+ * @return Czy tablica leży w arenie?
+ */
+bool MonoArrayInArena(const Mono *monos);
+
+/**
+ * Unieważnia informacje zapamiętane w nagłówku tablicy. Należy ją wywołać po każdej zmianie
+ * tablicy albo wielomianów w jej jednomianach.
+ * @param monos : tablica jednomianów.
+ */
+void MonoArrayInvalidate(Mono *monos);
+
+/**
+ * Zwraca liczbę bajtów zajmowanych w arenie przez tablicę jednomianów wraz z nagłówkiem.
+ * @param count : liczba jednomianów,
+ * @return rozmiar przydziału w bajtach.
+ */
+size_t MonoArrayAllocationSize(size_t count);
+
 #endif // SAFE_MEMORY_ALLOCATION
\ No newline at end of file
@@ -13,18 +13,24 @@
  */
 #define STARTING_CAPACITY 32
 
-Stack *CreateStack() {
+Stack *CreateStack(bool useRegions, bool useInterning, bool useCompression) {
     Stack *stack = SafeMalloc(sizeof(Stack));
     stack->capacity = STARTING_CAPACITY;
     stack->size = 0;
-    stack->array = SafeMalloc(stack->capacity * sizeof(Poly));
+    stack->useRegions = useRegions && !useCompression;
+    stack->useInterning = useInterning && !useCompression;
+    stack->useCompression = useCompression;
+    stack->unpacked = NULL;
+    stack->unpackedCount = 0;
+    stack->unpackedCapacity = 0;
+    stack->array = SafeMalloc(stack->capacity * sizeof(PolyHandle *));
     return stack;
 }
 
 void ResizeStack(Stack *stack) {
     size_t newCapacity = stack->capacity * 2;
 
-    stack->array = SafeRealloc(stack->array, newCapacity * sizeof(Poly));
+    stack->array = SafeRealloc(stack->array, newCapacity * sizeof(PolyHandle *));
     stack->capacity = newCapacity;
 }
 
@@ -32,26 +38,180 @@ bool IsFull(Stack *stack) {
     return stack->size == stack->capacity;
 }
 
+/**
+ * Przygotowuje wielomian do przechowywania na stosie: zamienia go na współdzielony albo
+ * przenosi do własnego regionu, zależnie od ustawień stosu.
+ * @param stack : stos,
+ * @param p : wielomian,
+ * @return wielomian do zapisania na stosie.
+ */
+static Poly PrepareElement(Stack *stack, Poly p) {
+    if (stack->useInterning) {
+        return PolyIntern(&p);
+    }
+    if (stack->useRegions) {
+        return PolyMoveToRegion(&p);
+    }
+    return p;
+}
+
+/**
+ * Usuwa rozpakowane kopie wielomianów w postaci zwartej. Należy ją wywołać przed każdą zmianą
+ * stosu, bo rozpakowane kopie mogą należeć do uchwytów, które zaraz zostaną usunięte.
+ * @param stack : stos.
+ */
+static void ForgetUnpacked(Stack *stack) {
+    for (size_t i = 0; i < stack->unpackedCount; i++) {
+        PolyHandle *handle = stack->unpacked[i];
+        PolyDestroy(&handle->poly);
+        handle->poly = PolyZero();
+        handle->unpacked = false;
+    }
+    stack->unpackedCount = 0;
+}
+
+/**
+ * Tworzy uchwyt z licznikiem odwołań równym 1 dla wielomianu wstawianego na stos.
+ * @param stack : stos,
+ * @param p : wielomian, przejmowany na własność,
+ * @return uchwyt.
+ */
+static PolyHandle *CreateHandle(Stack *stack, Poly p) {
+    PolyHandle *handle = SafeMalloc(sizeof(PolyHandle));
+    *handle = (PolyHandle){.poly = PolyZero(), .refCount = 1, .visited = false, .tape = NULL,
+                           .compact = NULL, .unpacked = false};
+    if (stack->useCompression) {
+        handle->compact = PolyCompress(&p);
+        PolyDestroy(&p);
+    } else {
+        handle->poly = PrepareElement(stack, p);
+    }
+    return handle;
+}
+
 void Push(Stack *stack, Poly p) {
+    ForgetUnpacked(stack);
+    if (IsFull(stack)) {
+        ResizeStack(stack);
+    }
+    stack->array[stack->size++] = CreateHandle(stack, p);
+}
+
+void Duplicate(Stack *stack) {
+    assert(!IsEmpty(stack));
+    ForgetUnpacked(stack);
     if (IsFull(stack)) {
         ResizeStack(stack);
     }
-    stack->array[stack->size++] = p;
+    PolyHandle *handle = stack->array[stack->size - 1];
+    handle->refCount++;
+    stack->array[stack->size++] = handle;
+}
+
+/**
+ * Usuwa zapamiętaną w uchwycie taśmę, jeśli ją skompilowano.
+ * @param handle : uchwyt.
+ */
+static void ForgetTape(PolyHandle *handle) {
+    if (handle->tape != NULL) {
+        PolyTapeDestroy(handle->tape);
+        handle->tape = NULL;
+    }
+}
+
+/**
+ * Zwalnia odwołanie do uchwytu, usuwając go wraz z wielomianem po zwolnieniu ostatniego.
+ * @param handle : uchwyt.
+ */
+static void ReleaseHandle(PolyHandle *handle) {
+    if (--handle->refCount == 0) {
+        ForgetTape(handle);
+        PolyDestroy(&handle->poly);
+        CompactPolyDestroy(handle->compact);
+        free(handle);
+    }
 }
 
 Poly Pop(Stack *stack) {
     assert(!IsEmpty(stack));
-    return stack->array[--stack->size];
+    ForgetUnpacked(stack);
+    PolyHandle *handle = stack->array[--stack->size];
+    if (handle->refCount > 1) {
+        handle->refCount--;
+        return handle->compact != NULL ? PolyDecompress(handle->compact)
+                                       : PolyClone(&handle->poly);
+    }
+
+    Poly p = handle->poly;
+    if (handle->compact != NULL) {
+        p = PolyDecompress(handle->compact);
+        CompactPolyDestroy(handle->compact);
+    }
+    ForgetTape(handle);
+    free(handle);
+    return p;
+}
+
+void Discard(Stack *stack) {
+    assert(!IsEmpty(stack));
+    ForgetUnpacked(stack);
+    ReleaseHandle(stack->array[--stack->size]);
+}
+
+Poly PeekAt(Stack *stack, size_t depth) {
+    assert(depth < stack->size);
+    PolyHandle *handle = stack->array[stack->size - 1 - depth];
+    if (handle->compact != NULL && !handle->unpacked) {
+        if (stack->unpackedCount == stack->unpackedCapacity) {
+            stack->unpackedCapacity = 2 * stack->unpackedCapacity + 2;
+            stack->unpacked =
+                SafeRealloc(stack->unpacked, stack->unpackedCapacity * sizeof(PolyHandle *));
+        }
+        stack->unpacked[stack->unpackedCount++] = handle;
+        handle->poly = PolyDecompress(handle->compact);
+        handle->unpacked = true;
+    }
+    return handle->poly;
 }
 
-Poly Peek(Stack *stack) {
+const PolyTape *PeekTape(Stack *stack) {
     assert(!IsEmpty(stack));
-    return stack->array[stack->size - 1];
+    PolyHandle *handle = stack->array[stack->size - 1];
+    if (handle->tape == NULL) {
+        Poly p = PeekAt(stack, 0);
+        handle->tape = PolyCompile(&p);
+    }
+    return handle->tape;
+}
+
+void TransformAll(Stack *stack, Poly (*function)(Poly *)) {
+    ForgetUnpacked(stack);
+    for (size_t i = 0; i < stack->size; i++) {
+        PolyHandle *handle = stack->array[i];
+        if (!handle->visited) {
+            handle->visited = true;
+            ForgetTape(handle);
+            if (handle->compact != NULL) {
+                Poly p = PolyDecompress(handle->compact);
+                Poly result = function(&p);
+                CompactPolyDestroy(handle->compact);
+                handle->compact = PolyCompress(&result);
+                PolyDestroy(&result);
+            } else {
+                handle->poly = PrepareElement(stack, function(&handle->poly));
+            }
+        }
+    }
+    for (size_t i = 0; i < stack->size; i++) {
+        stack->array[i]->visited = false;
+    }
 }
 
 void DestroyStack(Stack *stack) {
+    ForgetUnpacked(stack);
+    free(stack->unpacked);
     for (size_t i = 0; i < stack->size; i++) {
-        PolyDestroy(&stack->array[i]);
+        ReleaseHandle(stack->array[i]);
     }
     free(stack->array);
     free(stack);
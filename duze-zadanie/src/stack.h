@@ -9,12 +9,28 @@
 #ifndef POLYNOMIALS_STACK_H
 #define POLYNOMIALS_STACK_H
 
+#include "compact_poly.h"
 #include "poly.h"
+#include "poly_tape.h"
 #include "safe_memory_allocation.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdlib.h>
 
+/**
+ * Uchwyt wielomianu na stosie z licznikiem odwołań. Polecenie CLONE wstawia na stos ten sam
+ * uchwyt, a wielomian jest kopiowany dopiero wtedy, gdy ma zostać zmieniony, a wskazuje na niego
+ * więcej niż jedna pozycja stosu (ang. copy-on-write).
+ */
+typedef struct PolyHandle {
+    Poly poly;            ///< wielomian; dla wielomianu w postaci zwartej jego rozpakowana kopia
+    size_t refCount;      ///< liczba pozycji stosu wskazujących na uchwyt
+    bool visited;         ///< znacznik używany przy przechodzeniu po różnych uchwytach stosu
+    PolyTape *tape;       ///< skompilowany wielomian albo NULL, jeśli jeszcze go nie skompilowano
+    CompactPoly *compact; ///< wielomian w postaci zwartej albo NULL, jeśli trzymamy drzewo
+    bool unpacked;        ///< czy pole poly zawiera rozpakowaną kopię postaci zwartej
+} PolyHandle;
+
 /**
  * Struktura reprezentująca stos.
  */
@@ -28,18 +44,50 @@ typedef struct Stack {
      */
     size_t capacity;
     /**
-     * Tablica przechowująca elementy stosu.
+     * Tablica przechowująca uchwyty elementów stosu.
+     */
+    PolyHandle **array;
+    /**
+     * Informacja, czy każdy wielomian na stosie jest trzymany we własnym regionie.
+     */
+    bool useRegions;
+    /**
+     * Informacja, czy wielomiany na stosie są zamieniane na współdzielone węzły.
+     */
+    bool useInterning;
+
+    /**
+     * Informacja, czy wielomiany na stosie są trzymane w postaci zwartej.
      */
-    Poly *array;
+    bool useCompression;
+
+    /**
+     * Uchwyty, których postać zwartą rozpakowano od ostatniej zmiany stosu.
+     */
+    PolyHandle **unpacked;
+
+    /**
+     * Liczba uchwytów w tablicy unpacked.
+     */
+    size_t unpackedCount;
+
+    /**
+     * Pojemność tablicy unpacked.
+     */
+    size_t unpackedCapacity;
 } Stack;
 
 /**
  * Tworzy stos. Ustawia jego capacity na podany w argumentach rozmiar,
  * wartość top ustawia na -1, alokuje pamięć na tablicę rozmiaru capacity.
- * @param capacity : rozmiar stosu.
+ * @param useRegions : czy wstawiane wielomiany przenosić do własnych regionów,
+ * @param useInterning : czy wstawiane wielomiany zamieniać na współdzielone węzły; ma
+ * pierwszeństwo przed regionami,
+ * @param useCompression : czy wstawiane wielomiany trzymać w postaci zwartej; ma
+ * pierwszeństwo przed regionami i współdzielonymi węzłami.
  * @return wskaźnik na stos.
  */
-Stack *CreateStack();
+Stack *CreateStack(bool useRegions, bool useInterning, bool useCompression);
 
 /**
  * Zwiększa rozmiar stosu.
@@ -75,14 +123,27 @@ static inline size_t StackSize(Stack *stack) {
 
 /**
  * Dodaje wielomian na szczyt stosu. Inkrementuje top o jeden.
- * Jeśli stos jest zapełniony, zwiększa go.
+ * Jeśli stos jest zapełniony, zwiększa go. Jeśli stos trzyma wielomiany
+ * w postaci zwartej, we współdzielonych węzłach albo w regionach, zapisuje
+ * wielomian w postaci zwartej, zamienia go na współdzielony albo przenosi go
+ * do własnego regionu.
  * @param stack : stos
  * @param p : wielomian do dodania
  */
 void Push(Stack *stack, Poly p);
 
 /**
- * Ściąga element z góry stosu.
+ * Wstawia na szczyt stosu kopię elementu z góry stosu. Kopia współdzieli
+ * uchwyt z oryginałem, więc wielomian nie jest kopiowany.
+ * Wywołanie funkcji na pustym stosie to błąd.
+ * @param stack : stos.
+ */
+void Duplicate(Stack *stack);
+
+/**
+ * Ściąga element z góry stosu i przekazuje wielomian na własność
+ * wywołującego. Jeśli uchwyt jest współdzielony z inną pozycją stosu, zwraca
+ * kopię wielomianu.
  * Wywołanie funkcji na pustym stosie to błąd.
  * @param stack : stos,
  * @return wielomian ściągnięty z góry stosu.
@@ -90,10 +151,45 @@ void Push(Stack *stack, Poly p);
 Poly Pop(Stack *stack);
 
 /**
- * Zwraca ostatni element stosu.
+ * Usuwa element z góry stosu, nie kopiując wielomianu.
+ * Wywołanie funkcji na pustym stosie to błąd.
+ * @param stack : stos.
+ */
+void Discard(Stack *stack);
+
+/**
+ * Zwraca element stosu do odczytu, nie kopiując go. Element trzymany w postaci zwartej jest
+ * rozpakowywany, a rozpakowana kopia żyje do najbliższej zmiany stosu.
+ * @param stack : stos,
+ * @param depth : głębokość elementu; 0 oznacza górę stosu,
+ * @return element stosu.
+ */
+Poly PeekAt(Stack *stack, size_t depth);
+
+/**
+ * Zwraca ostatni element stosu do odczytu, nie kopiując go.
  * @return element na górze stosu.
  */
-Poly Peek(Stack *stack);
+static inline Poly Peek(Stack *stack) {
+    return PeekAt(stack, 0);
+}
+
+/**
+ * Zwraca skompilowany wielomian z wierzchołka stosu. Taśma jest kompilowana przy pierwszym
+ * wywołaniu i zapamiętywana w uchwycie, więc kolejne wyliczenia tego samego wielomianu nie
+ * przechodzą już jego drzewa.
+ * @param stack : niepusty stos,
+ * @return taśma wielomianu z wierzchołka stosu.
+ */
+const PolyTape *PeekTape(Stack *stack);
+
+/**
+ * Zastępuje każdy wielomian na stosie wynikiem funkcji, przygotowując go tak
+ * jak Push. Współdzielony uchwyt jest przetwarzany raz.
+ * @param stack : stos,
+ * @param function : funkcja przejmująca wielomian na własność.
+ */
+void TransformAll(Stack *stack, Poly (*function)(Poly *));
 
 /**
  * Usuwa stos i czyści pamięć po wielomianach które się w nim znajdują.
@@ -1,7 +1,7 @@
 #!/usr/bin/env bash
 
-if (($# != 2)); then
-    echo "Usage $0 ./<program> <directory>"
+if (($# < 2)); then
+    echo "Usage $0 ./<program> <directory> [<program options>...]"
     exit 1
 fi
 
@@ -13,6 +13,9 @@ VALGRIND_ERROR_CODE=33
 VALGRIND="  "
 PROGRAM=$1
 DIRECTORY=$2
+shift 2
+OPTIONS=("$@")
+FAILED=0
 
 temp_out=$(mktemp)
 temp_err=$(mktemp)
@@ -21,7 +24,7 @@ trap 'rm -f "temp_err"' INT TERM HUP EXIT
 
 for i in $DIRECTORY/*.in ; do
     echo "Test ${i#*$DIRECTORY/}..."
-    cat "$i" | $VALGRIND "$PROGRAM"  2>"$temp_err" 1>"$temp_out"
+    cat "$i" | $VALGRIND "$PROGRAM" "${OPTIONS[@]}" 2>"$temp_err" 1>"$temp_out"
     VALGRIND_EXIT_CODE=$?
 
     if ((VALGRIND_EXIT_CODE == VALGRIND_ERROR_CODE)); then
@@ -37,8 +40,12 @@ for i in $DIRECTORY/*.in ; do
             echo -e "${GREEN}Prawidlowe wyjscie${NOCOLOR}"
         else
             echo -e "${RED}Nieprawidlowe wyjscie na stderr${NOCOLOR}"
+            FAILED=1
         fi
     else
         echo -e "${RED}Nieprawidlowe wyjscie na stdout${NOCOLOR}"
+        FAILED=1
     fi
-done
\ No newline at end of file
+done
+
+exit $FAILED
\ No newline at end of file
@@ -0,0 +1,242 @@
+/** @file
+ * Implementacja puli wątków z podkradaniem zadań (ang. work stealing).
+ *
+ * Każdy wątek ma własną kolejkę dwustronną. Zadania zgłoszone przez wątek trafiają na koniec
+ * jego kolejki i stamtąd są przez niego wyjmowane, więc najpierw wykonuje najmniejsze, ostatnio
+ * wydzielone podproblemy. Bezczynny wątek podkrada zadania z początku cudzych kolejek, czyli
+ * najstarsze i zwykle największe.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#include "thread_pool.h"
+#include "safe_memory_allocation.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Zadanie oczekujące w kolejce.
+ */
+typedef struct {
+    TaskFunction function; ///< wykonywana funkcja
+    void *arg;             ///< argument funkcji
+    TaskGroup *group;      ///< grupa, do której należy zadanie
+} Task;
+
+/**
+ * Kolejka dwustronna zadań jednego wątku, trzymana w buforze cyklicznym.
+ */
+typedef struct {
+    pthread_mutex_t lock; ///< blokada chroniąca kolejkę
+    Task *tasks;          ///< bufor cykliczny zadań
+    size_t capacity;      ///< rozmiar bufora
+    size_t head;          ///< indeks najstarszego zadania
+    size_t size;          ///< liczba zadań w kolejce
+} TaskDeque;
+
+/**
+ * Stan puli wątków. Kolejka o indeksie 0 należy do wątków spoza puli, pozostałe do kolejnych
+ * wątków pomocniczych.
+ */
+static struct {
+    TaskDeque *deques;         ///< kolejki zadań, o jedną więcej niż wątków pomocniczych
+    pthread_t *workers;        ///< wątki pomocnicze
+    size_t workerCount;        ///< liczba wątków pomocniczych
+    atomic_size_t queued;      ///< górne oszacowanie liczby zadań we wszystkich kolejkach
+    pthread_mutex_t sleepLock; ///< blokada chroniąca usypianie wątków pomocniczych
+    pthread_cond_t wakeUp;     ///< budzi wątki pomocnicze po zgłoszeniu zadania
+    size_t sleeping;           ///< liczba uśpionych wątków pomocniczych
+    bool stopping;             ///< czy wątki pomocnicze mają się zakończyć
+} pool = {.sleepLock = PTHREAD_MUTEX_INITIALIZER, .wakeUp = PTHREAD_COND_INITIALIZER};
+
+/**
+ * Indeks kolejki bieżącego wątku.
+ */
+static _Thread_local size_t currentDeque = 0;
+
+/**
+ * Dokłada zadanie na koniec kolejki, powiększając bufor w razie potrzeby.
+ * @param deque : kolejka,
+ * @param task : zadanie.
+ */
+static void PushBottom(TaskDeque *deque, Task task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->size == deque->capacity) {
+        size_t capacity = deque->capacity == 0 ? 16 : 2 * deque->capacity;
+        Task *tasks = SafeMalloc(capacity * sizeof(Task));
+        for (size_t i = 0; i < deque->size; i++) {
+            tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+        }
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->capacity = capacity;
+        deque->head = 0;
+    }
+    deque->tasks[(deque->head + deque->size++) % deque->capacity] = task;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+/**
+ * Wyjmuje zadanie z kolejki: z końca, jeśli wyjmuje właściciel, albo z początku, jeśli
+ * zadanie jest podkradane.
+ * @param deque : kolejka,
+ * @param steal : czy zadanie jest podkradane,
+ * @param task : wskaźnik na zapisanie zadania,
+ * @return false, jeśli kolejka była pusta.
+ */
+static bool PopTask(TaskDeque *deque, bool steal, Task *task) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->size > 0;
+    if (found) {
+        deque->size--;
+        if (steal) {
+            *task = deque->tasks[deque->head];
+            deque->head = (deque->head + 1) % deque->capacity;
+        } else {
+            *task = deque->tasks[(deque->head + deque->size) % deque->capacity];
+        }
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return found;
+}
+
+/**
+ * Szuka zadania do wykonania: najpierw we własnej kolejce, potem w kolejkach pozostałych
+ * wątków.
+ * @param task : wskaźnik na zapisanie zadania,
+ * @return false, jeśli nie znaleziono zadania.
+ */
+static bool FindTask(Task *task) {
+    if (atomic_load(&pool.queued) == 0) {
+        return false;
+    }
+
+    size_t dequeCount = pool.workerCount + 1;
+    for (size_t i = 0; i < dequeCount; i++) {
+        size_t index = (currentDeque + i) % dequeCount;
+        if (PopTask(&pool.deques[index], i != 0, task)) {
+            atomic_fetch_sub(&pool.queued, 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Wykonuje zadanie i oznacza je jako zakończone.
+ * @param task : zadanie.
+ */
+static void RunTask(const Task *task) {
+    task->function(task->arg);
+    atomic_fetch_sub(&task->group->pending, 1);
+}
+
+/**
+ * Pętla wątku pomocniczego: wykonuje zadania, a gdy ich brakuje, zasypia do zgłoszenia
+ * nowego zadania albo zamknięcia puli.
+ * @param arg : indeks kolejki wątku.
+ * @return NULL.
+ */
+static void *WorkerLoop(void *arg) {
+    currentDeque = (size_t)(uintptr_t)arg;
+
+    while (true) {
+        Task task;
+        if (FindTask(&task)) {
+            RunTask(&task);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool.sleepLock);
+        while (atomic_load(&pool.queued) == 0 && !pool.stopping) {
+            pool.sleeping++;
+            pthread_cond_wait(&pool.wakeUp, &pool.sleepLock);
+            pool.sleeping--;
+        }
+        bool stop = pool.stopping && atomic_load(&pool.queued) == 0;
+        pthread_mutex_unlock(&pool.sleepLock);
+
+        if (stop) {
+            return NULL;
+        }
+    }
+}
+
+void ThreadPoolSetThreadCount(size_t count) {
+    pthread_mutex_lock(&pool.sleepLock);
+    pool.stopping = true;
+    pthread_cond_broadcast(&pool.wakeUp);
+    pthread_mutex_unlock(&pool.sleepLock);
+
+    for (size_t i = 0; i < pool.workerCount; i++) {
+        pthread_join(pool.workers[i], NULL);
+    }
+    if (pool.deques != NULL) {
+        for (size_t i = 0; i <= pool.workerCount; i++) {
+            pthread_mutex_destroy(&pool.deques[i].lock);
+            free(pool.deques[i].tasks);
+        }
+    }
+    free(pool.deques);
+    free(pool.workers);
+    pool.deques = NULL;
+    pool.workers = NULL;
+    pool.workerCount = 0;
+    pool.stopping = false;
+
+    if (count <= 1) {
+        return;
+    }
+    pool.deques = SafeMalloc(count * sizeof(TaskDeque));
+    for (size_t i = 0; i < count; i++) {
+        pool.deques[i] = (TaskDeque){.tasks = NULL, .capacity = 0, .head = 0, .size = 0};
+        pthread_mutex_init(&pool.deques[i].lock, NULL);
+    }
+    pool.workers = SafeMalloc((count - 1) * sizeof(pthread_t));
+    while (pool.workerCount < count - 1 &&
+           pthread_create(&pool.workers[pool.workerCount], NULL, WorkerLoop,
+                          (void *)(uintptr_t)(pool.workerCount + 1)) == 0) {
+        pool.workerCount++;
+    }
+    for (size_t i = pool.workerCount + 1; i < count; i++) {
+        pthread_mutex_destroy(&pool.deques[i].lock);
+    }
+}
+
+size_t ThreadPoolThreadCount(void) {
+    return pool.workerCount + 1;
+}
+
+void ThreadPoolSpawn(TaskGroup *group, TaskFunction function, void *arg) {
+    if (pool.workerCount == 0) {
+        function(arg);
+        return;
+    }
+
+    atomic_fetch_add(&group->pending, 1);
+    atomic_fetch_add(&pool.queued, 1);
+    Task task = {.function = function, .arg = arg, .group = group};
+    PushBottom(&pool.deques[currentDeque], task);
+
+    pthread_mutex_lock(&pool.sleepLock);
+    if (pool.sleeping > 0) {
+        pthread_cond_signal(&pool.wakeUp);
+    }
+    pthread_mutex_unlock(&pool.sleepLock);
+}
+
+void ThreadPoolWait(TaskGroup *group) {
+    while (atomic_load(&group->pending) > 0) {
+        Task task;
+        if (FindTask(&task)) {
+            RunTask(&task);
+        } else {
+            sched_yield();
+        }
+    }
+}
@@ -0,0 +1,60 @@
+/** @file
+ * Interfejs puli wątków wykonującej zadania obliczeń na wielomianach.
+ *
+ * Zadania są zgłaszane w grupach; oczekujący na zakończenie grupy wątek sam wykonuje zadania
+ * z kolejek, więc zadania mogą zgłaszać i oczekiwać na własne podzadania na dowolnej głębokości
+ * rekurencji.
+ *
+ * @author Gabriela Olszewska <go418326@students.mimuw.edu.pl>
+ * @copyright Uniwersytet Warszawski
+ * @date 05.2021
+ */
+
+#ifndef POLYNOMIALS_THREAD_POOL_H
+#define POLYNOMIALS_THREAD_POOL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/**
+ * Funkcja wykonywana jako zadanie.
+ */
+typedef void (*TaskFunction)(void *arg);
+
+/**
+ * Grupa zadań, na których zakończenie można oczekiwać.
+ */
+typedef struct {
+    atomic_size_t pending; ///< liczba zgłoszonych i niezakończonych zadań
+} TaskGroup;
+
+/**
+ * Zmienia liczbę wątków wykonujących obliczenia, licząc wątek wywołujący. Nie może być
+ * wywoływana w trakcie wykonywania zadań.
+ * @param count : liczba wątków; 0 i 1 oznaczają obliczenia sekwencyjne.
+ */
+void ThreadPoolSetThreadCount(size_t count);
+
+/**
+ * Zwraca liczbę wątków wykonujących obliczenia, licząc wątek wywołujący.
+ * @return liczba wątków.
+ */
+size_t ThreadPoolThreadCount(void);
+
+/**
+ * Zgłasza zadanie w grupie. Jeśli pula nie ma wątków pomocniczych, zadanie jest wykonywane
+ * od razu.
+ * @param group : grupa zadania,
+ * @param function : wykonywana funkcja,
+ * @param arg : argument funkcji.
+ */
+void ThreadPoolSpawn(TaskGroup *group, TaskFunction function, void *arg);
+
+/**
+ * Czeka na zakończenie wszystkich zadań grupy, w międzyczasie wykonując zadania
+ * z kolejek.
+ * @param group : grupa zadań.
+ */
+void ThreadPoolWait(TaskGroup *group);
+
+#endif // POLYNOMIALS_THREAD_POOL_H